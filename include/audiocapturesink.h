@@ -0,0 +1,60 @@
+#ifndef AUDIOCAPTURESINK_H
+#define AUDIOCAPTURESINK_H
+
+#include <QIODevice>
+#include <QAudioSource>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QVector>
+#include <functional>
+#include "audioconverter.h"
+
+// Push-mode target for one QAudioSource. Converts the device's native format
+// to 16 kHz mono float and hands it to an output callback. Lives on the
+// capture thread. During a device switch two sinks run side by side, but only
+// the live one forwards samples, so the ring behind the output keeps a
+// single producer.
+class AudioCaptureSink : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    using Output = std::function<void(const float *samples, int count)>;
+
+    AudioCaptureSink(const QAudioDevice &device, Output output, QObject *parent = nullptr);
+    ~AudioCaptureSink();
+
+    bool start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // Not live: callbacks are discarded, but the first one emits ready()
+    void setLive(bool live) { m_live = live; }
+    bool isLive() const { return m_live; }
+
+    QAudioDevice device() const { return m_device; }
+    AudioConverter &converter() { return m_converter; }
+
+signals:
+    void ready(); // The device delivered its first buffer
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    QAudioDevice m_device;
+    QAudioFormat m_format;
+    QAudioSource *m_source = nullptr;
+    Output m_output;
+    bool m_running = false;
+    bool m_live = true;
+    bool m_announced = false;
+
+    AudioConverter m_converter;
+    QVector<float> m_scratch;
+    char m_carry[64];      // A frame split across two callbacks
+    int m_carryBytes = 0;
+};
+
+#endif // AUDIOCAPTURESINK_H
@@ -0,0 +1,61 @@
+#ifndef AUDIOCONVERTER_H
+#define AUDIOCONVERTER_H
+
+#include <cstdint>
+#include <vector>
+
+// Converts whatever the capture device delivers (UInt8/Int16/Int32/Float,
+// any channel count, any rate) into the 16 kHz mono float whisper expects.
+// Sample conversion and the polyphase FIR are vectorised with SSE/AVX when
+// available. configure() allocates; process() never does, so it is safe to
+// call from the capture callback.
+class AudioConverter
+{
+public:
+    enum SampleFormat { UInt8, Int16, Int32, Float };
+
+    static const int kTargetRate = 16000;
+    static const int kChunkFrames = 2048; // Max input frames per process() call
+
+    AudioConverter();
+
+    void configure(SampleFormat format, int sampleRate, int channels);
+    void reset(); // Drop filter history (new stream, same format)
+
+    // Converts up to kChunkFrames interleaved frames; returns samples written
+    // to out, which must hold maxOutputSamples() floats.
+    int process(const char *data, int frames, float *out);
+
+    int maxOutputSamples() const;
+    int bytesPerFrame() const { return m_bytesPerSample * m_channels; }
+    bool isPassthrough() const { return m_format == Float && m_channels == 1 && m_up == m_down; }
+
+    // Running cost, for the logs and the --bench-audio microbenchmark
+    double microsPerSecondOfAudio() const;
+    void resetStats();
+
+private:
+    void toMonoFloat(const char *data, int frames, float *dest);
+    int resample(const float *in, int count, float *out);
+
+    SampleFormat m_format = Float;
+    int m_sampleRate = kTargetRate;
+    int m_channels = 1;
+    int m_bytesPerSample = 4;
+
+    // Polyphase resampler: rate * up / down == 16 kHz
+    int m_up = 1;
+    int m_down = 1;
+    int m_taps = 0;                  // Taps per phase
+    std::vector<float> m_bank;       // m_up phases x m_taps, reversed for a forward dot product
+    std::vector<float> m_work;       // History (m_taps - 1) followed by the current chunk
+    int64_t m_nextPos = 0;           // Next output position, in upsampled units
+
+    std::vector<float> m_interleaved;
+    std::vector<float> m_mono;
+
+    int64_t m_costNanos = 0;
+    int64_t m_framesIn = 0;
+};
+
+#endif // AUDIOCONVERTER_H
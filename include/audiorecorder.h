@@ -6,37 +6,169 @@
 #include <QMediaDevices>
 #include <QAudioDevice>
 #include <QVector>
-#include <QIODevice>
+#include <QThread>
+#include <QTimer>
 #include <QDebug>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include "audiocapturesink.h"
+#include "dspchain.h"
+#include "metersnapshot.h"
+#include "triplebuffer.h"
+#include "audioringbuffer.h"
+#include "recordingbuffer.h"
+#include "recordingjournal.h"
+#include "spectrumanalyzer.h"
+#include "voiceactivitydetector.h"
 
-class AudioRecorder : public QIODevice
+class AudioRecorder : public QObject
 {
     Q_OBJECT
 
 public:
     explicit AudioRecorder(QObject *parent = nullptr);
     ~AudioRecorder();
-    
-    void start();
-    void stop();
+
+    // Begin a take. triggerNs (nowNs() in the hotkey or button handler) is
+    // when the user asked for it; the latency log counts from there.
+    void start(qint64 triggerNs = 0);
+    static qint64 nowNs(); // Steady clock
+    void stop();  // End the take (capture keeps running while armed)
+    // Switches input without ending the take: the new source is opened on the
+    // capture thread and replaces the old one once it delivers audio.
     void setDevice(const QAudioDevice &device);
+    QAudioDevice device() const { return currentDevice; }
     static QList<QAudioDevice> availableDevices();
-    QVector<float> getRecordedAudio();
+    RecordingView getRecordedAudio() const;
+    RecordingView getSpeechAudio() const; // Leading/trailing silence trimmed, as of stop(); empty if no speech
+    std::shared_ptr<RecordingJournal> journal() const; // Last take's journal; null when off or unavailable
+
+    // Armed mode: keep capturing between takes into a bounded pre-roll ring
+    // that is spliced onto the front of the next take. 0 disarms. ms only
+    // bounds memory; the CPU cost while armed is one drain per
+    // kArmedDrainIntervalMs, whatever the length.
+    void setPrerollMs(int ms);
+    bool isArmed() const { return m_prerollMs > 0; }
+
+    void reloadSettings();
+
+    // Pipelined transcription: while chunking is on, the take is cut at pauses
+    // (or, failing that, every 20 s with a second of overlap) and each finished
+    // chunk goes to the sink from the pipeline thread. stop() flushes the open
+    // chunk. Leading and trailing silence never reach the sink.
+    using ChunkSink = std::function<void(const RecordingView &chunk, bool overlapped)>;
+    void setChunkSink(const ChunkSink &sink);
+    void setChunking(bool enabled) { m_chunkingEnabled = enabled; } // Applies from the next take
+
+    // Metering is pulled, not pushed: the GUI polls once per display frame and
+    // gets the latest snapshot (false if none is newer). While no meter view is
+    // visible, the pipeline skips the spectrum work.
+    bool latestMeter(MeterSnapshot &snapshot) { return m_meter.read(snapshot); }
+    void setMeteringActive(bool active) { m_meteringActive.store(active, std::memory_order_relaxed); }
 
 signals:
     void audioAvailable(const QVector<float> &data);
-    void audioLevel(float level);
-    void frequencyBands(const QVector<float> &bands); // 6 frequency bands
+    void deviceChanged(const QAudioDevice &device);   // Includes automatic switches
+    void inputsChanged();                             // Devices were added or removed
 
-protected:
-    qint64 readData(char *data, qint64 maxlen) override;
-    qint64 writeData(const char *data, qint64 len) override;
+private slots:
+    void onInputsChanged();
 
 private:
-    QAudioSource *audioSource = nullptr;
-    QAudioFormat format;
-    QAudioDevice currentDevice;
-    QVector<float> m_recordedAudio;
+    void startCapture();
+    void stopCapture();
+    void requestDevice(const QAudioDevice &device);
+    void pushCaptured(const float *samples, int count); // Capture thread, real-time
+
+    // Capture thread
+    void prepareDevice(const QAudioDevice &device);
+    void promotePending();
+    void dropPending();
+
+    // Pipeline thread
+    void drain();
+    void beginTake();
+    void endTake();
+    void pushPreroll(const float *data, qint64 count);
+    void processTake(const float *data, qint64 count);
+    void appendToTake(const float *data, qint64 count);
+    void prepareSpareJournal();
+    void cutChunks(bool endOfTake);
+    void emitChunk(qint64 end, bool overlapped);
+
+    RecordingView takeView() const;
+
+    QAudioDevice currentDevice;   // Active input
+    QAudioDevice m_requestedDevice; // Latest requested; active once its source delivers
+    QMediaDevices *m_mediaDevices = nullptr;
+    bool m_followDefault = true; // Track the system default until the user picks a device
+    bool m_capturing = false;
+
+    // Capture thread: owns the sources. m_pending is a replacement device
+    // warming up; it goes live on its first buffer, or is dropped on timeout.
+    QThread *m_captureThread = nullptr;
+    QObject *m_captureContext = nullptr;
+    AudioCaptureSink *m_sink = nullptr;
+    AudioCaptureSink *m_pending = nullptr;
+    qint64 m_switchStartNs = 0;
+
+    // Capture callback -> pipeline thread handoff (no allocation in the callback)
+    AudioRingBuffer m_ring;
+    QThread *m_pipelineThread = nullptr;
+    QTimer *m_drainTimer = nullptr;
+    QVector<float> m_drainScratch;
+    quint64 m_reportedDrops = 0;
+    std::atomic<bool> m_takeActive{false}; // Written on the pipeline thread only
+
+    // Hotkey-to-first-sample latency (steady clock, ns)
+    std::atomic<qint64> m_startNs{0};
+    std::atomic<bool> m_awaitingFirstSample{false};
+    std::atomic<qint64> m_firstSampleNs{-1};
+
+    // Pre-roll (pipeline thread)
+    std::atomic<int> m_prerollMs{0};
+    QVector<float> m_preroll;
+    qint64 m_prerollWrite = 0;
+    qint64 m_prerollFill = 0;
+
+    // Pipeline-thread analysis
+    SpectrumAnalyzer m_spectrum;
+    TripleBuffer<MeterSnapshot> m_meter;
+    std::atomic<bool> m_meteringActive{false};
+    float m_meterBands[MeterSnapshot::kBands] = {};
+    bool m_meterHasBands = false;
+    quint64 m_meterSequence = 0;
+    VoiceActivityDetector m_vad;
+    bool m_vadEnabled = true;
+
+    // Optional clean-up before VAD and inference (high-pass, noise suppression, AGC)
+    DspChain m_dsp;
+    QVector<float> m_dspScratch;
+    bool m_dspEnabled = false;
+    bool m_dspActive = false; // m_dspEnabled as of the current take's start
+
+    // Pipelined transcription (pipeline thread)
+    ChunkSink m_chunkSink;
+    std::atomic<bool> m_chunkingEnabled{false};
+    bool m_chunkingActive = false; // Latched per take
+    qint64 m_takeSamples = 0;
+    qint64 m_chunkStart = -1;      // Open chunk's first sample; -1 until speech resumes
+    qint64 m_lastCut = 0;
+    bool m_chunkOverlapped = false;
+    size_t m_segmentsSeen = 0;
+
+    // The take streams into an on-disk journal; m_recording only holds what the
+    // journal could not take (journaling off, or the disk filled up mid-take)
+    RecordingBuffer m_recording;
+    mutable QMutex m_journalMutex;
+    std::shared_ptr<RecordingJournal> m_journal;
+    std::shared_ptr<RecordingJournal> m_spareJournal; // Created between takes, off the start path
+    // The finished take's speech, worked out by endTake() so the GUI thread
+    // never reads the pipeline's VAD; unset means keep the whole take
+    VoiceActivityDetector::Segment m_speechBounds;
+    bool m_hasSpeechBounds = false;
+    bool m_journalEnabled = true;
 };
 
 #endif // AUDIORECORDER_H
@@ -0,0 +1,47 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Lock-free single-producer / single-consumer ring of float samples.
+// The producer is the QAudioSource callback (AudioRecorder::writeData), the
+// consumer is the capture pipeline thread. Storage is allocated once in the
+// constructor; write() and read() never allocate or block.
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(size_t capacity); // Rounded up to a power of two
+    ~AudioRingBuffer() = default;
+
+    AudioRingBuffer(const AudioRingBuffer &) = delete;
+    AudioRingBuffer &operator=(const AudioRingBuffer &) = delete;
+
+    // Producer side. Returns how many samples were stored; the rest are
+    // dropped (and counted) when the consumer falls behind.
+    size_t write(const float *data, size_t count);
+
+    // Consumer side. Returns how many samples were copied into dest.
+    size_t read(float *dest, size_t maxCount);
+
+    size_t available() const;
+    size_t capacity() const { return m_capacity; }
+
+    // Total samples dropped because the ring was full
+    uint64_t droppedSamples() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<float[]> m_buffer;
+    size_t m_capacity;
+    size_t m_mask;
+
+    // Keep the two indices on separate cache lines so producer and consumer
+    // don't bounce the same line between cores.
+    alignas(64) std::atomic<size_t> m_writePos{0};
+    alignas(64) std::atomic<size_t> m_readPos{0};
+    alignas(64) std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,67 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+// Which logical CPUs are fast and which are efficient, read once from sysfs.
+// Intel hybrid parts list their P- and E-cores under /sys/devices/cpu_core and
+// /sys/devices/cpu_atom; big.LITTLE ARM exposes a per-CPU cpu_capacity; failing
+// both, cores whose top clock (cpufreq) is well below the fastest count as
+// efficiency cores. Only CPUs this process may run on are considered. On a
+// homogeneous CPU every core is a performance core and pinning does nothing.
+class CpuTopology
+{
+public:
+    enum CoreClass { Performance, Efficiency };
+
+    static const CpuTopology &instance();
+
+    bool isHybrid() const { return !m_efficiency.isEmpty(); }
+    const QVector<int> &performanceCores() const { return m_performance; }
+    const QVector<int> &efficiencyCores() const { return m_efficiency; }
+    int computeCpuCount() const { return qMax(1, int(m_performance.size())); } // Inference threads worth running
+    QString describe() const;                    // e.g. "hybrid (cpu_core/cpu_atom): P 0-7, E 8-15"
+    QString classify(const QVector<int> &cpus) const; // e.g. "P 0-3 E 9"
+
+    // Restricts the calling thread, and threads it creates from then on, to
+    // one class of core. Returns false (and changes nothing) if not hybrid.
+    bool pinCurrentThread(CoreClass coreClass) const;
+
+    static QVector<int> parseCpuList(const QString &list); // sysfs "0-3,8,10-11"
+    static QString formatCpuList(QVector<int> cpus);
+
+private:
+    CpuTopology();
+    bool detectIntelHybrid(const QVector<int> &allowed);
+    bool detectByValue(const QVector<int> &allowed, const QString &file, const QString &source);
+
+    QVector<int> m_performance;
+    QVector<int> m_efficiency;
+    QString m_source;
+};
+
+// Which CPUs did a job's threads actually run on? Samples per-thread CPU time
+// and last-run CPU from /proc/self/task while the job runs. Threads that did a
+// meaningful share of the work count; the odd audio or GUI wakeup does not.
+class CoreUsageProbe
+{
+public:
+    void begin();
+    void sample();      // Cheap to call often: reads /proc at most every 50 ms
+    QVector<int> end(); // CPUs the busy threads were seen on
+
+private:
+    void read();
+
+    QElapsedTimer m_started;
+    QElapsedTimer m_lastRead;
+    QHash<int, qint64> m_ticks;      // Per thread: CPU time at the previous read
+    QHash<int, qint64> m_busyTicks;  // Per thread: CPU time since begin()
+    QHash<int, QSet<int>> m_cpus;    // Per thread: CPUs seen while it was busy
+};
+
+#endif // CPUTOPOLOGY_H
@@ -0,0 +1,28 @@
+#ifndef DECODERBENCHMARK_H
+#define DECODERBENCHMARK_H
+
+#include <QString>
+
+// Command-line benchmarks for the decoder, run with
+//   com.toice.app --bench-audio-ctx [corpus-dir] [--model path]
+//   com.toice.app --bench-long-form [file.wav] [--model path]
+// Like DspBenchmark's, they need no display and print to stdout.
+class DecoderBenchmark
+{
+public:
+    // Encoder time and transcript agreement with the encoder sized to each clip
+    // versus the full window, per clip-length bucket. Without a corpus it uses
+    // the reference clip and prefixes of it.
+    static int runAudioContext(const QString &corpusDir, const QString &modelPath);
+
+    // Wall time of a long recording split at pauses and decoded 1, 2, 4...
+    // chunks at a time, cores shared between them. Without a file it uses the
+    // reference clip repeated with pauses in between.
+    static int runLongForm(const QString &wavPath, const QString &modelPath);
+
+    // Shared with DspBenchmark's corpus decode
+    static bool openSettings(); // Once, on first use
+    static QString resolveModel(const QString &modelPath); // --model, else the configured one, else the bundled one
+};
+
+#endif // DECODERBENCHMARK_H
@@ -0,0 +1,62 @@
+#ifndef DECODINGPOLICY_H
+#define DECODINGPOLICY_H
+
+#include <QString>
+#include "whisper.h"
+
+// How final and chunk jobs decode. whisper's own temperature fallback
+// re-decodes a failing window up to five times with no regard for time, so it
+// is switched off and done here instead, per segment and against a latency
+// budget: once the budget is spent the best hypothesis so far is kept.
+//
+// With dynamicAudioCtx, clips up to 10 s run the encoder over their own
+// length plus a margin instead of the full 30 s window, as one segment with
+// no carried-over context. Short dictation is encoder-bound, so this is where
+// most of its time goes.
+struct DecodingPolicy
+{
+    enum Strategy { Greedy, BeamSearch };
+
+    Strategy strategy = Greedy;
+    int beamSize = 5;
+    int bestOf = 3;                 // Candidates sampled per fallback (temperature > 0)
+    int maxFallbacks = 2;           // Re-decodes of one failing segment, at rising temperature
+    float entropyThreshold = 2.4f;  // Token entropy below this: repetition loop
+    float logprobThreshold = -1.0f; // Mean token log-probability below this: low confidence
+    int budgetMs = 2000;            // Per job; 0 = unlimited
+    bool dynamicAudioCtx = false;   // Size the encoder to short clips
+
+    // decode_preset (fast / balanced / accurate) with per-field overrides. GUI thread.
+    static DecodingPolicy fromSettings();
+    QString describe() const;
+
+    // Encoder positions (20 ms each) for a clip of this many samples, margin
+    // included; 0 (whisper's full 1500) when that would not save anything
+    static int audioContextFor(qint64 samples);
+
+    void apply(whisper_full_params &wparams) const;
+
+    // What every decode in the app starts from: English, nothing printed, n
+    // threads. Partials and the self-test use it as is; params() adds the
+    // policy, which is what final and chunk jobs decode with. Benchmarks and
+    // model measurements build theirs the same way so their numbers hold.
+    static whisper_full_params baseParams(int threads);
+    whisper_full_params params(int threads) const;
+
+    struct Result {
+        QString text;
+        int fallbacks = 0;      // Re-decodes run
+        int unresolved = 0;     // Segments still below threshold
+        bool budgetHit = false; // A fallback was wanted but the budget was spent
+        qint64 ms = 0;
+        double encodeMs = 0.0;  // Encoder passes, first pass and fallbacks together
+        int audioCtx = 0;       // First pass; 0 = full window
+    };
+
+    // First pass with wparams (apply() already called), then fallbacks for
+    // failing segments while the budget lasts. False if the first pass failed.
+    bool decode(whisper_context *ctx, whisper_state *state, whisper_full_params wparams,
+                const float *pcm, int samples, Result &result) const;
+};
+
+#endif // DECODINGPOLICY_H
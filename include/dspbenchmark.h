@@ -0,0 +1,22 @@
+#ifndef DSPBENCHMARK_H
+#define DSPBENCHMARK_H
+
+#include <QString>
+
+// Command-line microbenchmarks for the capture side, run with
+//   com.toice.app --bench-audio
+//   com.toice.app --bench-dsp [corpus-dir] [--model path]
+// (the decoder's are in DecoderBenchmark, --bench-models in ModelCatalog).
+// They need neither a display nor an audio device and print to stdout.
+class DspBenchmark
+{
+public:
+    // Cost of AudioConverter per second of audio for common device formats
+    static int runConversion();
+
+    // Cost of each DspChain stage; with a directory of .wav files, also the
+    // whisper decode time of every file with and without the chain
+    static int runDsp(const QString &corpusDir, const QString &modelPath);
+};
+
+#endif // DSPBENCHMARK_H
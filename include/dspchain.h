@@ -0,0 +1,76 @@
+#ifndef DSPCHAIN_H
+#define DSPCHAIN_H
+
+#include <cstdint>
+#include <vector>
+#include "fft.h"
+
+// Optional clean-up stage between capture and inference, for 16 kHz mono:
+//   1. High-pass (2nd-order Butterworth, 80 Hz): removes DC, rumble and handling noise
+//   2. Spectral subtraction: 512-point STFT with a sqrt-Hann analysis/synthesis
+//      pair at 50% overlap, a per-bin noise floor that tracks minima, and a
+//      floored, time-smoothed gain so the residual doesn't turn "musical"
+//   3. AGC: brings active speech towards -20 dBFS RMS, rising slowly, falling
+//      fast, with a peak limiter, so quiet speakers reach whisper at a usable level
+// The STFT delays the stream by up to one frame; process() returns whatever
+// is ready and flush() drains the tail at the end of a take. The learned noise
+// profile and gain survive reset(), so the next take starts adapted.
+// All buffers are sized in the constructor; process() never allocates.
+class DspChain
+{
+public:
+    static const int kFrameSize = 512;
+    static const int kHop = kFrameSize / 2;
+    static const int kMaxExtraOutput = kHop; // process() writes at most count + kHop samples
+
+    explicit DspChain(int sampleRate = 16000);
+
+    void setStages(bool highPass, bool suppression, bool agc);
+    void reset(); // New stream: drops buffered samples and filter history
+
+    int process(const float *in, int count, float *out);
+    int flush(float *out); // At most kFrameSize samples
+
+    // Running cost, for the logs and the --bench-dsp benchmark
+    double microsPerSecondOfAudio() const;
+    void resetStats();
+
+private:
+    void highPass(float *samples, int count);
+    void suppressFrame(); // m_frame -> overlap-add into m_overlap
+    int emitHop(float *out);
+    void autoGain(float *samples, int count);
+
+    int m_sampleRate;
+    bool m_highPass = true;
+    bool m_suppression = true;
+    bool m_agc = true;
+
+    // Biquad, transposed direct form II
+    float m_b0, m_b1, m_b2, m_a1, m_a2;
+    float m_z1 = 0.0f, m_z2 = 0.0f;
+
+    // STFT
+    Fft m_fft;
+    std::vector<float> m_window;  // sqrt-Hann, used for analysis and synthesis
+    std::vector<float> m_frame;   // Input history, kFrameSize
+    int m_frameFill = 0;
+    std::vector<float> m_overlap; // Overlap-add accumulator, kFrameSize
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_power;   // Per-bin power, smoothed over frames
+    std::vector<float> m_noise;   // Per-bin noise floor (tracked minimum of m_power)
+    std::vector<float> m_gain;    // Per-bin smoothed gain
+    int64_t m_skip = 0;           // Priming output still to discard
+    int64_t m_owed = 0;           // Input samples not yet returned as output
+
+    int m_framesSeen = 0;         // Noise estimate converges quickly at first
+
+    // AGC
+    float m_agcGain = 1.0f;
+
+    int64_t m_costNanos = 0;
+    int64_t m_samplesIn = 0;
+};
+
+#endif // DSPCHAIN_H
@@ -0,0 +1,29 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+
+// Radix-2 complex FFT on split real/imaginary arrays. Twiddles and the
+// bit-reversal table are built once in the constructor; transforms run in
+// place and never allocate. Butterflies use AVX or SSE when the build enables
+// them (the Flatpak build uses -mavx2) and fall back to scalar code otherwise.
+class Fft
+{
+public:
+    explicit Fft(int size); // Must be a power of two
+    int size() const { return m_size; }
+
+    void forward(float *re, float *im) const;
+    void inverse(float *re, float *im) const; // Scaled by 1/N
+
+private:
+    void bitReverse(float *re, float *im) const;
+    void butterflies(float *re, float *im) const;
+
+    int m_size;
+    std::vector<int> m_swaps;      // Index pairs to swap for bit reversal
+    std::vector<float> m_twiddleRe; // Per stage, contiguous so SIMD can load them
+    std::vector<float> m_twiddleIm;
+};
+
+#endif // FFT_H
@@ -6,8 +6,20 @@
 #include <QVector>
 #include <QMutex>
 #include <QQueue>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <QDebug>
 #include "whisper.h"
+#include "recordingbuffer.h"
+#include "transcriptstitcher.h"
+#include "whisperstatepool.h"
+#include "cputopology.h"
+#include "decodingpolicy.h"
 
 class InferenceWorker : public QThread
 {
@@ -17,28 +29,157 @@ public:
     explicit InferenceWorker(QObject *parent = nullptr);
     ~InferenceWorker();
     
-    void addAudio(const QVector<float> &audio);
-    void stop();
-    void clear();
-    void requestFinalTranscription(const QVector<float> &audio);
-    void reloadModel(const QString &modelPath);
+    using AudioSource = std::function<RecordingView()>; // Returns the take so far; called on the worker thread
+
+    // Live partials: while streaming, the worker pulls the growing take from
+    // source on a budgeted cadence, re-decodes the uncommitted tail and emits
+    // transcriptionUpdated(committed segment, true) / (unstable tail, false).
+    void startStreaming(const AudioSource &source);
+    void stopStreaming();
+    void stop();  // Wakes the worker and aborts a decode in progress
+    void clear(); // Drops queued jobs
+    void requestFinalTranscription(const RecordingView &audio);
+
+    // Pipelined mode: chunks of the take are decoded in the background as they
+    // are cut; finishChunks() queues behind them and emits finalResultReady
+    // with the stitched text, so at stop only the last chunk is left to decode.
+    void addChunk(const RecordingView &chunk, bool overlapped); // Any thread
+    void finishChunks();
+    // Loads a model on a background thread and returns at once. A replacement
+    // is swapped in between jobs only after it initialises and passes a short
+    // self-test; until then (and if it fails) the current model keeps serving.
+    // With no model yet, queued transcriptions wait for the first one.
+    void loadModel(const QString &modelPath);
+    static QString configuredModelPath(); // model_path setting, or the bundled fallback
+    static int configuredThreads(QString *source = nullptr); // Override, calibrated or default
+    void reloadSettings(); // inference_threads override / calibrated thread count
+
+    // Residency: an idle model is released after model_idle_minutes, or sooner
+    // when /proc/pressure/memory reaches model_evict_pressure. wakeModel()
+    // reloads it in the background, so call it as a take starts: jobs of that
+    // take wait for the reload, which runs while the user is still speaking.
+    enum Residency { Unloaded, Loading, Resident, Evicted };
+    Residency residency() const { return Residency(m_residency.load()); }
+    static QString residencyName(Residency residency); // "unloaded", "loading", "resident", "evicted"
+    void wakeModel(); // GUI thread; no-op unless evicted
 
 signals:
     void transcriptionUpdated(QString text, bool isFinal);
     void finalResultReady(QString text);
+    void modelLoadProgress(int percent);
+    void modelReady(QString modelPath);
+    void modelFailed(QString modelPath, QString reason);
+    void threadsCalibrated(int threads, QString cpu, QString modelPath);
+    void decodeBudgetStats(quint64 jobs, quint64 budgetHits); // This session, after each final or chunk job
+    void residencyChanged(QString residency); // residencyName()
 
 protected:
     void run() override;
 
 private:
-    struct whisper_context *ctx = nullptr;
-    QQueue<float> audioBuffer;
+    struct Job {
+        enum Kind { Final, Chunk, FinishChunks };
+        Kind kind = Final;
+        RecordingView audio;
+        bool overlapped = false;
+    };
+
+    using Model = std::shared_ptr<WhisperStatePool>; // A context and its decoding states
+
+    void startLoader();
+    struct LoadOptions {
+        bool mapped = true;     // model_mmap: read the file through a read-only mapping
+        bool prefault = true;   // model_prefault: start readahead of the whole file at once
+        int states = 2;         // whisper_states: decoding states per model
+        bool calibrate = false; // Sweep thread counts once the model serves
+        bool warmup = true;     // model_warmup: decode a clip in the background once the model serves
+        bool selfTest = true;   // Off when reloading an evicted model that already passed
+    };
+    LoadOptions configuredLoadOptions(const QString &modelPath) const;
+    void queueLoad(const QString &modelPath, const LoadOptions &options);
+    void setResidency(Residency residency);
+    void checkResidency(); // GUI thread, on m_residencyTimer
+    static double memoryPressure(); // PSI "some" avg10 in percent; < 0 if unavailable
+
+    void loadInBackground(const QString &modelPath, const LoadOptions &options); // Loader thread
+    bool selfTest(WhisperStatePool &candidate, QString &reason);
+    void warmUp(WhisperStatePool &model, qint64 selfTestMs);
+    void calibrateThreads(WhisperStatePool &model, const QString &modelPath);
+
+    void enqueue(const Job &job);
+    void transcribeChunk(const RecordingView &chunk, bool overlapped);
+
+    whisper_full_params decodeParams(int threads);
+    bool decodeWithPolicy(const float *pcm, int samples, whisper_full_params wparams, QString &text);
+    void transcribeFinal(const RecordingView &recording);
+    void transcribeLongForm(const RecordingView &recording);
+    void transcribePartial(const RecordingView &take);
+    void resetStream();
+    static bool shouldAbort(void *userData);
+    static bool shouldAbortPartial(void *userData);
+
     QMutex mutex;
-    bool m_stop = false;
-    bool m_shouldClear = false;
-    
-    QVector<float> m_finalProcessingBuffer;
-    bool m_hasFinalRequest = false;
+    std::atomic<bool> m_stop{false};
+
+    // Models. m_model is what the next job starts with; a running job keeps its
+    // own reference, so a swap never frees a context mid-decode. ctx and state
+    // are the current job's (worker thread only). Guarded by mutex otherwise.
+    Model m_model;
+    struct whisper_context *ctx = nullptr;
+    struct whisper_state *state = nullptr;
+    WhisperStatePool *m_jobModel = nullptr; // Extra states for long-form jobs
+    QThread *m_loader = nullptr;
+    QString m_nextModelPath;    // Requested while a load was running; latest wins
+    bool m_hasNextLoad = false;
+    bool m_loading = false;
+    LoadOptions m_nextLoadOptions;
+    QString m_servingPath;        // File behind m_model
+    QString m_evictedPath;        // Reloaded by wakeModel()
+    QElapsedTimer m_idleSince;    // Since the worker last went idle
+    std::atomic<int> m_residency{Unloaded};
+    QTimer *m_residencyTimer = nullptr;
+    qint64 m_idleEvictMs = 0;     // 0 = never; GUI thread
+    double m_evictPressure = 0.0; // 0 = never; GUI thread
+
+    std::atomic<int> m_threads{4};        // Threads per decode
+    std::atomic<int> m_threadOverride{0}; // inference_threads; 0 = calibrated
+    std::atomic<quint64> m_jobsStarted{0};
+    const WhisperStatePool *m_lastJobModel = nullptr; // To log the first job on each model (worker thread)
+    CoreUsageProbe m_usage;  // Which CPUs the current job ran on (worker thread)
+    bool m_probing = false;
+
+    // Final and chunk decoding; m_policy is guarded by mutex, the rest is the worker's
+    DecodingPolicy m_policy;
+    DecodingPolicy m_jobPolicy; // m_policy as of the current job's start
+    quint64 m_policyJobs = 0;
+    quint64 m_budgetHits = 0;
+
+    // Guarded by mutex; the worker sleeps on m_wake while the queue is empty
+    QQueue<Job> m_jobs;
+    QWaitCondition m_wake;
+
+    // Streaming. Source, deadline and latency samples are guarded by mutex; the
+    // window state below them is only touched on the worker thread.
+    AudioSource m_streamSource;
+    bool m_streamRestart = false;
+    QDeadlineTimer m_nextPartial{QDeadlineTimer::Forever};
+    QVector<qint64> m_partialLatencies; // Worst-case audio-to-text ms per partial, this take
+    std::atomic<bool> m_abortPartial{false}; // A final job or stop is waiting behind the partial
+    qint64 m_committedSamples = 0;  // Take position up to which text is committed
+    qint64 m_lastDecodedSize = 0;
+    QString m_committedText;        // Fed back as the prompt for the next window
+    QByteArray m_prompt;
+    int m_stepMs = 0;               // Wait between partial decodes, adapted to decode cost
+    int m_streamThreads = 1;
+    double m_decodeMs = 0.0;        // Smoothed partial decode time
+    QVector<float> m_windowScratch;
+
+    // Pipelined mode (worker thread, except the reset flag which is under mutex)
+    TranscriptStitcher m_stitcher;
+    bool m_chunksReset = false;
+    int m_chunkCount = 0;
+
+    QVector<float> m_pcmScratch; // Reused gather buffer when a view isn't contiguous
     
     // Parameters
     int sampleRate = 16000;
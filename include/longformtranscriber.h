@@ -0,0 +1,54 @@
+#ifndef LONGFORMTRANSCRIBER_H
+#define LONGFORMTRANSCRIBER_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "whisper.h"
+#include "recordingbuffer.h"
+#include "decodingpolicy.h"
+#include "whisperstatepool.h"
+
+// Long recordings (meetings, voice notes) as independent chunks. The take is
+// cut at pauses the VAD finds, so no chunk needs the text before it, and the
+// chunks are decoded side by side on several whisper states with a share of
+// the cores each. whisper's cost grows with threads far less than linearly,
+// so a few narrower decodes at once finish well before one wide one would.
+// The texts are joined in order with TranscriptStitcher.
+class LongFormTranscriber
+{
+public:
+    static const int kMinSamples = 30 * 16000; // Shorter takes fit one window: no point splitting
+    static const int kMaxParallel = 4;
+
+    struct Chunk {
+        qint64 start = 0;
+        qint64 length = 0;
+        bool overlapped = false; // Hard cut inside speech: shares audio with the previous chunk
+    };
+
+    struct Stats {
+        int chunks = 0;
+        int parallel = 0;        // States decoding at once
+        int threadsPerChunk = 0;
+        int budgetHits = 0;      // Chunks whose fallbacks ran out of budget
+        qint64 ms = 0;
+    };
+
+    // Up to ~28 s each, cut in the widest pause near the end; leading,
+    // trailing and long inner silences are left out entirely
+    static QVector<Chunk> split(const RecordingView &audio);
+
+    // Decodes at once for this many threads: half of them, up to kMaxParallel
+    static int parallelismFor(int threads);
+
+    // Any thread. firstState is the caller's; the others come from the pool,
+    // never more than its cap in all, and go back when this returns. wparams
+    // (policy already applied) sets the threads per chunk. Decodes every
+    // chunk under the policy, so its budget applies per chunk.
+    static QString transcribe(WhisperStatePool &pool, whisper_state *firstState, const RecordingView &audio,
+                              const DecodingPolicy &policy, const whisper_full_params &wparams, int parallel,
+                              const std::atomic<bool> *cancel, Stats *stats = nullptr);
+};
+
+#endif // LONGFORMTRANSCRIBER_H
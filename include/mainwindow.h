@@ -13,6 +13,7 @@
 #include <QSystemTrayIcon>
 #include <QPushButton>
 #include <QElapsedTimer>
+#include <QTimer>
 #include "globalshortcut.h"
 #include <QCloseEvent>
 #include <QMenu>
@@ -21,6 +22,7 @@
 #include <QPainter>
 #include <QClipboard>
 #include <QGuiApplication>
+#include <QHash>
 
 class HistoryItemWidget : public QWidget {
     Q_OBJECT
@@ -126,15 +128,23 @@ public slots:
     void toggleFromRemote();
     void startFromRemote();
     void stopFromRemote();
+    QString modelResidency(); // DBus: "resident", "loading", "evicted" or "unloaded"
     void showOverlay();
     void updateTranscription(QString text, bool isFinal);
     void onDeviceChanged(int index);
-    void updateAudioLevel(float level);
+    void refreshDevices();
+    void recoverJournals();
+    void transcribeNextRecovered();
+    void updateMeters();
     void toggleTranscription();
     void toggleRecording(bool useOverlay = false);
     void showMainWindow();
+    void showSettingsDialog();
     void typeText();
 
+signals:
+    Q_SCRIPTABLE void modelResidencyChanged(QString residency); // Also on DBus
+
 protected:
     void closeEvent(QCloseEvent *event) override;
 
@@ -142,6 +152,7 @@ private:
     void setupUi();
     void setupTray();
     void addHistoryItem(const QString &text, const QString &time, bool prepend = false);
+    void setModelStatus(const QString &text, const QString &color);
     
     OverlayWidget *overlay;
     // QListWidget *historyList; // REPLACED
@@ -150,23 +161,34 @@ private:
     QVBoxLayout *historyLayout;
     
     InferenceWorker *inference;
-    AudioRecorder *audio;
+    AudioRecorder *audio = nullptr;
     QLabel *liveLabel;
     QLabel *msgTimeLabel; 
+    QLabel *m_modelStatus = nullptr;
+    bool m_modelLoaded = false;
+    QString m_requestedModelPath; // From settings; becomes model_path once it loads
     QSystemTrayIcon *trayIcon;
     
     QComboBox *deviceSelector;
     QProgressBar *audioMeter;
+    QTimer *m_meterTimer = nullptr;
     QPushButton *btnRecord;
     bool isRecording = false;
     bool m_isFinalizing = false;
     QList<QAudioDevice> devices;
     GlobalShortcut *m_shortcut;
     bool m_usingOverlay = false;
+    QString m_transcriptionMode; // "batch", "pipelined" or "streaming"
+    QString m_takeMode;      // m_transcriptionMode as of the current take's start
+    QHash<QString, QVector<qint64>> m_stopLatencies; // Stop-to-text ms per mode, this session
+    QString m_liveCommitted; // Streaming mode: settled text of the current take
+    QString m_livePartial;   // ...and the tail that may still change
 
 
 
     QElapsedTimer m_finalizationStartTime;
+    std::shared_ptr<RecordingJournal> m_pendingJournal; // Removed once its transcription arrives
+    QStringList m_recoveryQueue;
     
     // UI Members for visibility toggling
     QLabel *micIcon;
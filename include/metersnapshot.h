@@ -0,0 +1,19 @@
+#ifndef METERSNAPSHOT_H
+#define METERSNAPSHOT_H
+
+#include <QtGlobal>
+
+// One frame of metering published by the audio pipeline: aggregated over
+// everything captured since the previous frame, small enough to copy around.
+struct MeterSnapshot
+{
+    static const int kBands = 6;
+
+    float peak = 0.0f;         // Max |sample|, 0..1
+    float rms = 0.0f;          // 0..1
+    float bands[kBands] = {};  // Log-spaced spectrum bands, 0..1
+    bool hasBands = false;
+    quint64 sequence = 0;      // Increments with every published frame
+};
+
+#endif // METERSNAPSHOT_H
@@ -0,0 +1,66 @@
+#ifndef MODELCATALOG_H
+#define MODELCATALOG_H
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include "decodingpolicy.h"
+
+// The ggml whisper models on this machine, f16 and quantized alike. Size and
+// quantization come from the file header rather than the file name, so
+// renamed or hand-converted files are described correctly. Each model can be
+// measured on a bundled reference clip (real-time factor and word accuracy);
+// measurements are kept in the database until the file changes.
+class ModelCatalog
+{
+public:
+    struct Entry {
+        QString path;
+        QString family;       // "base.en", "medium", "large-v3"...
+        QString quantization; // "f16", "q5_0", "q8_0"...
+        qint64 bytes = 0;
+        QDateTime modified;
+        double rtf = -1.0;      // Decode time / audio time; < 0 until measured
+        double accuracy = -1.0; // 100 - WER on the reference clip, in percent
+
+        bool isMeasured() const { return rtf >= 0.0; }
+        bool isQuantized() const { return quantization.startsWith('q'); }
+        QString label() const; // "base.en q5_0, 57 MB, 0.08x real time, 98% accurate"
+    };
+
+    struct Reference {
+        QVector<float> pcm;
+        QString text;
+        bool isValid() const { return !pcm.isEmpty() && !text.isEmpty(); }
+    };
+
+    static QStringList searchDirs();
+    static bool readHeader(const QString &path, Entry &entry);
+
+    // GUI thread: scans searchDirs() and attaches saved measurements
+    static QVector<Entry> discover();
+    static void saveMeasurement(const Entry &entry);
+
+    // Fastest measured model at or above the accuracy floor (percent); -1 if none
+    static int recommend(const QVector<Entry> &entries, double accuracyFloor);
+
+    static Reference referenceClip();
+    static double wordAccuracy(const QString &reference, const QString &hypothesis);
+
+    // Any thread: loads the model the way InferenceWorker does, decodes the
+    // clip under policy once to warm up and once timed, and fills in rtf and
+    // accuracy. False if it failed or was cancelled.
+    static bool measure(Entry &entry, const Reference &reference, const DecodingPolicy &policy, int threads,
+                        const std::atomic<bool> *cancel);
+
+    // Local quantization uses whisper.cpp's quantize tool when it is installed
+    static QString quantizeTool(); // Empty if not found
+    static QString quantizedPath(const QString &source, const QString &type);
+
+    // com.toice.app --bench-models [--floor percent]
+    static int runBenchmark(double accuracyFloor);
+};
+
+#endif // MODELCATALOG_H
@@ -0,0 +1,53 @@
+#ifndef MODELFILE_H
+#define MODELFILE_H
+
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include "whisper.h"
+
+// Source of a ggml model for whisper_init_with_params. Mapped, the file is
+// mmap'd read-only and copied out of the page cache with no read() buffering;
+// pages already consumed are dropped from our resident set as the loader moves
+// on, so several instances on one machine share a single cached copy of the
+// file. prefault() asks the kernel to read the whole file ahead in the
+// background while ggml is still allocating. Unmapped, it falls back to plain
+// sequential reads.
+class ModelFile
+{
+public:
+    using Progress = std::function<void(int percent)>;
+
+    ModelFile() = default;
+    ~ModelFile();
+    ModelFile(const ModelFile &) = delete;
+    ModelFile &operator=(const ModelFile &) = delete;
+
+    bool open(const QString &path, bool mapped);
+    void prefault();
+    void setProgress(const Progress &progress) { m_progress = progress; }
+    void setCancel(const std::atomic<bool> *cancel) { m_cancel = cancel; } // Reads fail once set
+
+    whisper_model_loader loader(); // Valid while this object lives
+    qint64 size() const { return m_size; }
+    bool isMapped() const { return m_map != nullptr; }
+
+    static qint64 residentKb(); // VmRSS of this process, 0 if unknown
+
+private:
+    size_t read(void *output, size_t bytes);
+    void close();
+
+    QFile m_file;
+    int m_fd = -1;
+    uchar *m_map = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+    qint64 m_released = 0; // Mapped bytes already dropped from our resident set
+    int m_percent = -1;
+    Progress m_progress;
+    const std::atomic<bool> *m_cancel = nullptr;
+};
+
+#endif // MODELFILE_H
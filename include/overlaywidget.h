@@ -5,14 +5,14 @@
 #include <QLabel>
 #include <QTimer>
 #include <QElapsedTimer>
+#include "metersnapshot.h"
 class OverlayWidget : public QWidget {
     Q_OBJECT
 public:
     OverlayWidget(QWidget *parent = nullptr);
     enum OverlayState { Recording, Finalizing, Success };
     void updateStatus(bool isRecording);
-    void setAudioLevel(float level);
-    void setFrequencyBands(const QVector<float> &bands);
+    void setMeter(const MeterSnapshot &meter);
     void showSuccessState(); // Transition to rotating circle
     void showSuccessMessage(const QString &msg); // Transition to text message
 
@@ -36,6 +36,8 @@ private:
     float currentLevel = 0.0f;
     float m_barHeights[6]; // Store heights for each bar
     float m_barPhases[6];  // Independent timing for each bar
+    float m_bandLevels[6]; // Smoothed spectrum bands (0..1)
+    bool m_hasBands = false;
     QVector<float> waveHistory;
     
     // Animation State Machine
@@ -0,0 +1,69 @@
+#ifndef RECORDINGBUFFER_H
+#define RECORDINGBUFFER_H
+
+#include <QVector>
+#include <QMutex>
+#include <memory>
+
+// Read-only, reference-counted view over captured audio. A view is a list of
+// spans into immutable storage (recording blocks, later also file mappings)
+// and is cheap to copy and hand across threads: no sample data is copied.
+class RecordingView
+{
+public:
+    struct Span {
+        std::shared_ptr<const void> owner; // Keeps the storage alive
+        const float *data = nullptr;
+        qint64 length = 0;
+    };
+
+    RecordingView() = default;
+
+    qint64 size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    double durationSeconds(int sampleRate = 16000) const { return double(m_size) / sampleRate; }
+
+    // Zero-copy sub-range [start, start + length)
+    RecordingView mid(qint64 start, qint64 length = -1) const;
+
+    // Non-null when the whole view is backed by one contiguous span
+    const float *contiguousData() const;
+
+    // Gather the samples into dest (which must hold size() floats)
+    void copyTo(float *dest) const;
+
+    const QVector<Span> &spans() const { return m_spans; }
+    void appendSpan(const Span &span);
+
+private:
+    QVector<Span> m_spans;
+    qint64 m_size = 0;
+};
+
+// Append-only recording storage made of fixed-size blocks. The writer fills the
+// tail block in place; everything already handed out through view() is never
+// modified again, so readers on other threads need no further locking.
+class RecordingBuffer
+{
+public:
+    static const int kBlockSamples = 16384; // ~1 s at 16 kHz
+
+    RecordingBuffer() = default;
+
+    void append(const float *data, qint64 count); // Writer thread only
+    void clear();
+    RecordingView view() const;
+    qint64 size() const;
+
+private:
+    struct Block {
+        float samples[kBlockSamples];
+    };
+
+    mutable QMutex m_mutex;
+    QVector<std::shared_ptr<Block>> m_blocks;
+    int m_tailFill = kBlockSamples; // Samples used in the last block
+    qint64 m_size = 0;
+};
+
+#endif // RECORDINGBUFFER_H
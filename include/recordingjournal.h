@@ -0,0 +1,66 @@
+#ifndef RECORDINGJOURNAL_H
+#define RECORDINGJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include "recordingbuffer.h"
+
+// On-disk journal for one take: a memory-mapped file holding a small header
+// and the 16 kHz mono float samples. The pipeline thread appends with memcpy
+// into the mapping, writeback is started in large sequential ranges, and
+// pages older than a hot window are dropped from our resident set, so RAM
+// stays bounded however long the take runs. The samples form one contiguous
+// span, so whisper reads straight from the mapping. A journal that was never
+// marked transcribed survives a crash and is found again by pending().
+class RecordingJournal
+{
+public:
+    enum State : quint32 {
+        Recording = 1,
+        Finished = 2,
+        Transcribed = 3
+    };
+
+    static const int kMaxSeconds = 4 * 3600; // Address space reserved per take
+
+    ~RecordingJournal();
+
+    static QString defaultDirectory();
+    static std::shared_ptr<RecordingJournal> create(const QString &directory, int sampleRate = 16000);
+    static std::shared_ptr<RecordingJournal> open(const QString &path); // Read-only, for recovery
+    static QStringList pending(const QString &directory); // Unfinished journals not in use, newest first
+
+    bool append(const float *samples, qint64 count); // Writer thread only; false once full or failed
+    void finish();          // Take ended; still offered for recovery until transcribed
+    void markTranscribed(); // Done with it: the file is removed
+
+    RecordingView view() const;
+    qint64 size() const;
+    int sampleRate() const;
+    qint64 startedAtMs() const;
+    QString path() const { return m_path; }
+
+private:
+    struct Header;
+    struct Mapping;
+
+    RecordingJournal() = default;
+    static bool isInUse(const QString &path);
+    void writeBack();
+
+    QString m_path;
+    std::shared_ptr<Mapping> m_mapping;
+    Header *m_header = nullptr;
+    float *m_samples = nullptr;
+    qint64 m_capacity = 0;   // Samples that fit in the reservation
+    qint64 m_allocated = 0;  // Samples backed by allocated disk blocks
+    qint64 m_written = 0;
+    qint64 m_flushed = 0;    // Writeback started up to here
+    qint64 m_evicted = 0;    // Dropped from our resident set up to here
+    bool m_failed = false;
+    bool m_readOnly = false;
+};
+
+#endif // RECORDINGJOURNAL_H
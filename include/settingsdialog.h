@@ -3,9 +3,14 @@
 
 #include <QDialog>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QProcess>
+#include <QThread>
+#include <atomic>
+#include "modelcatalog.h"
 
 class SettingsDialog : public QDialog
 {
@@ -13,6 +18,7 @@ class SettingsDialog : public QDialog
     
 public:
     explicit SettingsDialog(QWidget *parent = nullptr);
+    ~SettingsDialog();
     QString getSelectedModelPath() const;
     int getSelectedShortcutPreset() const;
 
@@ -20,13 +26,38 @@ signals:
     void settingsSaved(QString modelPath, int presetIndex);
 
 private:
+    void refreshModels(const QString &selectPath);
+    void updateModelControls();
+    void startMeasuring();
+    void startQuantizing();
+
     QComboBox *comboModel;
     QLabel *lblModelPath;
     QPushButton *btnBrowse;
+    QPushButton *btnMeasure;
+    QPushButton *btnQuantize;
+    QComboBox *comboFloor;
+    QLabel *lblRecommendation;
+    QPushButton *btnUseRecommended;
     
     QComboBox *comboShortcut;
+    QComboBox *comboPreroll;
+    QCheckBox *checkDsp;
+    QComboBox *comboMode;
+    QComboBox *comboThreads;
+    QComboBox *comboDecoding;
+    QCheckBox *checkShortClips;
+    QComboBox *comboIdleUnload;
     
     QString m_customModelPath;
+
+    // Models found on disk; measuring runs on its own thread, quantizing in a child process
+    QVector<ModelCatalog::Entry> m_models;
+    int m_recommended = -1;
+    QThread *m_measureThread = nullptr;
+    std::atomic<bool> m_cancelMeasure{false};
+    QProcess *m_quantize = nullptr;
+    QString m_quantizeTarget;
 };
 
 #endif // SETTINGSDIALOG_H
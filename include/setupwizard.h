@@ -79,9 +79,14 @@ private:
             "QComboBox { background: white; color: #18181b; border: 1px solid #e4e4e7; border-radius: 8px; padding: 12px; font-size: 14px; font-weight: 500; }"
             "QComboBox::drop-down { border: none; width: 0px; }"
         );
-        modelSelector->addItem("Base (Optimized & Fast)", "base");
-        modelSelector->addItem("Small (Balanced)", "small");
-        modelSelector->addItem("Medium (High Accuracy)", "medium");
+        // Data is the file stem on the whisper.cpp model hub; quantized weights are
+        // a fraction of the size and decode faster on AVX2 CPUs
+        modelSelector->addItem("Base (Optimized & Fast)", "base.en");
+        modelSelector->addItem("Base, quantized q5_1 (57 MB, fastest)", "base.en-q5_1");
+        modelSelector->addItem("Small (Balanced)", "small.en");
+        modelSelector->addItem("Small, quantized q5_1 (181 MB)", "small.en-q5_1");
+        modelSelector->addItem("Medium (High Accuracy)", "medium.en");
+        modelSelector->addItem("Medium, quantized q5_0 (514 MB)", "medium.en-q5_0");
         bl->addWidget(modelSelector);
 
         progress = new QProgressBar(this);
@@ -115,10 +120,10 @@ private:
     }
 
     void startDownload() {
-        QString modelSize = modelSelector->currentData().toString();
+        QString modelName = modelSelector->currentData().toString();
         
         // CHECK FOR BUNDLED MODEL (Flatpak Optimization)
-        if (modelSize == "base") {
+        if (modelName == "base.en") {
             // Standard Flatpak install path
             QString bundledPath = "/app/share/toice/assets/models/ggml-base.en.bin";
             
@@ -137,12 +142,12 @@ private:
             }
         }
 
-        QString url = QString("https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-%1.en.bin").arg(modelSize);
+        QString url = QString("https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-%1.bin").arg(modelName);
         
         // Use standard writable path for Flatpak/Linux
         QString appData = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
         QDir().mkpath(appData + "/models");
-        QString dest = appData + "/models/ggml-" + modelSize + ".en.bin";
+        QString dest = appData + "/models/ggml-" + modelName + ".bin";
         
         QFile *file = new QFile(dest);
         if (!file->open(QIODevice::WriteOnly)) {
@@ -0,0 +1,47 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <vector>
+#include "fft.h"
+
+// Hann-windowed short-time spectrum with log-spaced bands, normalised to
+// 0..1 on a dB scale relative to full scale. Runs on the audio pipeline
+// thread; all buffers are sized in the constructor so process() never
+// allocates.
+class SpectrumAnalyzer
+{
+public:
+    SpectrumAnalyzer(int fftSize = 512, int sampleRate = 16000, int bandCount = 6,
+                     float minHz = 100.0f, float maxHz = 7000.0f);
+
+    // Feed samples; returns true if at least one new frame was analysed
+    bool process(const float *samples, int count);
+
+    int bandCount() const { return int(m_bands.size()); }
+    const float *bands() const { return m_bands.data(); }
+
+    // |X(k)|^2 of the latest frame, fftSize / 2 + 1 bins, 1.0 == full-scale sine
+    const float *powerSpectrum() const { return m_power.data(); }
+    int binCount() const { return int(m_power.size()); }
+    float binFrequency(int bin) const { return float(bin) * m_sampleRate / m_fft.size(); }
+
+    void reset();
+
+private:
+    void analyzeFrame();
+
+    Fft m_fft;
+    int m_sampleRate;
+    int m_hop;
+    int m_pending = 0; // New samples since the last frame
+
+    std::vector<float> m_window;
+    std::vector<float> m_history; // Last fftSize samples, oldest first
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_power;
+    std::vector<int> m_bandEdges; // bandCount + 1 bin indices
+    std::vector<float> m_bands;
+};
+
+#endif // SPECTRUMANALYZER_H
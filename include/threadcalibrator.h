@@ -0,0 +1,27 @@
+#ifndef THREADCALIBRATOR_H
+#define THREADCALIBRATOR_H
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "whisperstatepool.h"
+
+// Finds the fastest whisper thread count for this CPU and model by decoding a
+// fixed synthetic clip at several counts, best of two runs each. Too few threads leave cores idle;
+// too many oversubscribe small machines and sandboxes, so neither a fixed
+// number nor "all cores" is right everywhere.
+class ThreadCalibrator
+{
+public:
+    struct Result {
+        int threads = 0; // 0 if calibration was cancelled or failed
+        QVector<QPair<int, qint64>> timings; // (threads, ms)
+    };
+
+    static QString cpuModel(); // "model name" from /proc/cpuinfo plus the logical CPU count
+    static QVector<int> candidates(int cpus);
+    static Result run(WhisperStatePool &model, const std::atomic<bool> *cancel);
+};
+
+#endif // THREADCALIBRATOR_H
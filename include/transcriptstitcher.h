@@ -0,0 +1,30 @@
+#ifndef TRANSCRIPTSTITCHER_H
+#define TRANSCRIPTSTITCHER_H
+
+#include <QString>
+#include <QStringList>
+
+// Joins the transcripts of consecutive chunks of one take. Chunks cut inside
+// speech share a little audio with the previous chunk, so their first words
+// usually repeat the previous chunk's last ones; those are dropped. Chunks cut
+// at a pause share no audio and only lose an exact multi-word repeat, which is
+// a decoding artifact rather than something the speaker said.
+class TranscriptStitcher
+{
+public:
+    static const int kMaxOverlapWords = 8;
+
+    void clear();
+    void append(const QString &chunkText, bool overlapped);
+
+    QString text() const { return m_words.join(' '); }
+    QString tail(int maxChars) const; // Recent context, e.g. as the next chunk's prompt
+    bool isEmpty() const { return m_words.isEmpty(); }
+
+private:
+    static QString normalized(const QString &word);
+
+    QStringList m_words;
+};
+
+#endif // TRANSCRIPTSTITCHER_H
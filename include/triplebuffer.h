@@ -0,0 +1,41 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single-writer/single-reader handoff of the latest value. The
+// writer fills writeBuffer() and publish()es it; the reader picks up the most
+// recent published value, skipping any it missed. Neither side ever waits.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T &writeBuffer() { return m_buffers[m_write]; }
+
+    void publish()
+    {
+        const int previous = m_middle.exchange(m_write | kFresh, std::memory_order_acq_rel);
+        m_write = previous & kIndexMask;
+    }
+
+    // False if nothing new was published since the last read
+    bool read(T &out)
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        const int previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+        m_read = previous & kIndexMask;
+        out = m_buffers[m_read];
+        return true;
+    }
+
+private:
+    static const int kIndexMask = 3;
+    static const int kFresh = 4;
+
+    T m_buffers[3] = {};
+    int m_write = 0;               // Writer only
+    int m_read = 1;                // Reader only
+    std::atomic<int> m_middle{2};  // Shared slot, plus the fresh flag
+};
+
+#endif // TRIPLEBUFFER_H
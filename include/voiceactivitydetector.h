@@ -0,0 +1,71 @@
+#ifndef VOICEACTIVITYDETECTOR_H
+#define VOICEACTIVITYDETECTOR_H
+
+#include <cstdint>
+#include <vector>
+#include "fft.h"
+
+// Lightweight frame-based VAD for the capture pipeline. Each 32 ms frame is
+// classified from its energy against an adaptive noise floor plus two
+// spectral cues (share of energy in the speech band and spectral flatness).
+// A short onset requirement rejects clicks and an optional hangover keeps
+// word endings and short pauses inside a segment. Positions are absolute
+// sample indices since the last reset().
+class VoiceActivityDetector
+{
+public:
+    struct Segment {
+        int64_t start = 0; // Inclusive
+        int64_t end = 0;   // Exclusive
+    };
+
+    explicit VoiceActivityDetector(int sampleRate = 16000);
+
+    void reset();
+    void setHangoverMs(int ms);
+
+    void process(const float *samples, int count);
+    void finish(); // Close a segment that is still open at end of stream
+
+    const std::vector<Segment> &segments() const { return m_segments; }
+    bool hasSpeech() const { return !m_segments.empty() || m_inSpeech; }
+    bool inSpeech() const { return m_inSpeech; }
+    int64_t openSegmentStart() const { return m_inSpeech ? m_open.start : -1; }
+    int64_t samplesProcessed() const { return m_position; }
+
+    // First speech start to last speech end, widened by paddingMs on each side
+    // and clamped to what has been processed. Empty (start == end) if no speech.
+    Segment speechBounds(int paddingMs) const;
+
+private:
+    void classifyFrame();
+
+    static const int kFrameSize = 512;
+
+    Fft m_fft;
+    int m_sampleRate;
+    std::vector<float> m_frame;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    int m_frameFill = 0;
+    int64_t m_position = 0;   // Samples consumed
+    int64_t m_frameStart = 0; // Absolute position of m_frame[0]
+
+    int m_speechBinFrom;
+    int m_speechBinTo;
+
+    float m_noiseFloorDb = 0.0f;
+    bool m_floorInitialised = false;
+
+    int m_hangoverFrames = 0;
+    int m_onsetRun = 0;       // Consecutive speech-like frames while idle
+    int64_t m_onsetStart = 0;
+    int m_silenceRun = 0;     // Consecutive non-speech frames while in speech
+    int64_t m_lastSpeechEnd = 0;
+    bool m_inSpeech = false;
+    Segment m_open;
+
+    std::vector<Segment> m_segments;
+};
+
+#endif // VOICEACTIVITYDETECTOR_H
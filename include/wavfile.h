@@ -0,0 +1,15 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <QString>
+#include <QVector>
+
+// Reads the WAV files the benchmarks and the model reference clip come in
+class WavFile
+{
+public:
+    // 8/16/32-bit PCM or 32-bit float, any rate and channel count, as 16 kHz mono
+    static bool load(const QString &path, QVector<float> &out);
+};
+
+#endif // WAVFILE_H
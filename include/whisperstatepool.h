@@ -0,0 +1,70 @@
+#ifndef WHISPERSTATEPOOL_H
+#define WHISPERSTATEPOOL_H
+
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <memory>
+#include "whisper.h"
+
+class ModelFile;
+
+// A loaded whisper model plus the decoding states that run on it. The weights
+// live once in the context; each whisper_state carries its own KV caches and
+// compute buffers, allocated when the state is created and reused by every job
+// that leases it afterwards. Jobs holding different leases can decode on the
+// same model at the same time. The pool owns the context and frees it last.
+class WhisperStatePool
+{
+public:
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        ~Lease();
+
+        whisper_state *state() const { return m_state; }
+        explicit operator bool() const { return m_state != nullptr; }
+
+    private:
+        friend class WhisperStatePool;
+        Lease(WhisperStatePool *pool, whisper_state *state) : m_pool(pool), m_state(state) {}
+        void release();
+
+        WhisperStatePool *m_pool = nullptr;
+        whisper_state *m_state = nullptr;
+    };
+
+    // Takes ownership of ctx (loaded without a default state). One state is
+    // created up front; more are added on demand up to maxStates.
+    WhisperStatePool(whisper_context *ctx, int maxStates);
+    ~WhisperStatePool();
+    // Weights only, through file's loader, then the pool takes the context;
+    // null if the file isn't a usable model. How every model in the app is loaded.
+    static std::shared_ptr<WhisperStatePool> load(ModelFile &file, int maxStates);
+
+    WhisperStatePool(const WhisperStatePool &) = delete;
+    WhisperStatePool &operator=(const WhisperStatePool &) = delete;
+
+    bool isValid() const { return m_ctx && !m_all.isEmpty(); }
+    whisper_context *context() const { return m_ctx; }
+    int maxStates() const { return m_maxStates; }
+
+    Lease acquire();    // Waits while every state is in use and the pool is full
+    Lease tryAcquire(); // Empty lease instead of waiting
+
+private:
+    whisper_state *takeLocked(); // mutex held
+    void giveBack(whisper_state *state);
+
+    whisper_context *m_ctx;
+    int m_maxStates;
+    QMutex m_mutex;
+    QWaitCondition m_returned;
+    QVector<whisper_state*> m_all;
+    QVector<whisper_state*> m_free;
+};
+
+#endif // WHISPERSTATEPOOL_H
@@ -0,0 +1,114 @@
+#include "audiocapturesink.h"
+#include <QDebug>
+#include <cstring>
+
+AudioCaptureSink::AudioCaptureSink(const QAudioDevice &device, Output output, QObject *parent)
+    : QIODevice(parent), m_device(device), m_output(std::move(output))
+{
+    // Capture in the device's own format and convert to 16 kHz mono float
+    // ourselves, instead of hoping the sound server resamples for us.
+    m_format = m_device.preferredFormat();
+    if (!m_format.isValid() || m_format.sampleFormat() == QAudioFormat::Unknown) {
+        m_format.setSampleRate(16000);
+        m_format.setChannelCount(1);
+        m_format.setSampleFormat(QAudioFormat::Float);
+    }
+
+    AudioConverter::SampleFormat sampleFormat = AudioConverter::Float;
+    switch (m_format.sampleFormat()) {
+    case QAudioFormat::UInt8: sampleFormat = AudioConverter::UInt8; break;
+    case QAudioFormat::Int16: sampleFormat = AudioConverter::Int16; break;
+    case QAudioFormat::Int32: sampleFormat = AudioConverter::Int32; break;
+    default: sampleFormat = AudioConverter::Float; break;
+    }
+    m_converter.configure(sampleFormat, m_format.sampleRate(), m_format.channelCount());
+    m_scratch.resize(m_converter.maxOutputSamples());
+    qDebug() << m_device.description() << "captures at" << m_format.sampleRate() << "Hz,"
+             << m_format.channelCount() << "ch," << m_format.sampleFormat() << "-> 16 kHz mono float";
+
+    // Cheap: Qt 6 opens the device in start(), and the first buffer arrives one
+    // backend period after that. That wait is what a switch overlaps.
+    m_source = new QAudioSource(m_device, m_format, this);
+}
+
+AudioCaptureSink::~AudioCaptureSink()
+{
+    stop();
+}
+
+bool AudioCaptureSink::start()
+{
+    if (m_running) return true;
+    if (!isOpen()) {
+        open(QIODevice::WriteOnly);
+    }
+    m_converter.reset();
+    m_carryBytes = 0;
+    m_announced = false;
+    m_source->start(this); // Opens the device: the slow part of a switch
+    if (m_source->error() != QAudio::NoError) {
+        qWarning() << "Could not start" << m_device.description() << m_source->error();
+        m_source->stop();
+        return false;
+    }
+    m_running = true;
+    return true;
+}
+
+void AudioCaptureSink::stop()
+{
+    if (!m_running) return;
+    m_source->stop();
+    m_running = false;
+    close();
+}
+
+// QAudioSource calls this with captured audio.
+// Real-time path: converts into preallocated scratch, never allocates.
+qint64 AudioCaptureSink::writeData(const char *data, qint64 len)
+{
+    if (!m_live) {
+        if (!m_announced) {
+            m_announced = true;
+            emit ready(); // May make this sink live right away
+        }
+        if (!m_live) return len;
+    }
+
+    const int frameBytes = m_converter.bytesPerFrame();
+    if (frameBytes <= 0 || frameBytes > int(sizeof(m_carry))) return len;
+
+    const char *ptr = data;
+    qint64 remaining = len;
+
+    // Finish a frame that the previous callback split
+    if (m_carryBytes > 0) {
+        const int need = int(qMin<qint64>(frameBytes - m_carryBytes, remaining));
+        memcpy(m_carry + m_carryBytes, ptr, need);
+        m_carryBytes += need;
+        ptr += need;
+        remaining -= need;
+        if (m_carryBytes < frameBytes) return len;
+        const int produced = m_converter.process(m_carry, 1, m_scratch.data());
+        m_output(m_scratch.constData(), produced);
+        m_carryBytes = 0;
+    }
+
+    qint64 frames = remaining / frameBytes;
+    while (frames > 0) {
+        const int chunk = int(qMin<qint64>(frames, AudioConverter::kChunkFrames));
+        const int produced = m_converter.process(ptr, chunk, m_scratch.data());
+        m_output(m_scratch.constData(), produced);
+        ptr += qint64(chunk) * frameBytes;
+        frames -= chunk;
+    }
+
+    m_carryBytes = int(data + len - ptr);
+    if (m_carryBytes > 0) memcpy(m_carry, ptr, m_carryBytes);
+    return len;
+}
+
+qint64 AudioCaptureSink::readData(char *data, qint64 maxlen)
+{
+    return 0; // Write-only
+}
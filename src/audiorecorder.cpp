@@ -1,18 +1,89 @@
 #include "audiorecorder.h"
+#include "databasemanager.h"
+#include "cputopology.h"
+#include <QMetaMethod>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
-AudioRecorder::AudioRecorder(QObject *parent) : QIODevice(parent)
+// ~4 seconds at 16 kHz: enough headroom for the pipeline thread to be
+// descheduled for a while without the capture callback dropping samples.
+static const size_t kRingCapacity = 1 << 16;
+static const int kDrainIntervalMs = 16; // One meter snapshot per display frame (~60 Hz)
+static const int kArmedDrainIntervalMs = 100; // Between takes nothing is analysed, so wake rarely
+static const int kDrainChunk = 4096;
+static const int kSpeechPaddingMs = 200; // Kept around the detected speech so onsets aren't clipped
+static const int kMaxPrerollMs = 1000;
+static const int kSwitchTimeoutMs = 3000; // A replacement input must deliver audio within this
+static const int kMinChunkMs = 4000;      // Shorter chunks give whisper too little context
+static const int kMaxChunkMs = 20000;     // Stay well inside whisper's 30 s window
+static const int kChunkOverlapMs = 1000;  // Re-heard after a cut inside speech
+
+static qint64 steadyNowNs()
 {
-    currentDevice = QMediaDevices::defaultAudioInput();
-    if (currentDevice.isNull()) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AudioRecorder::AudioRecorder(QObject *parent) : QObject(parent), m_ring(kRingCapacity)
+{
+    m_drainScratch.resize(kDrainChunk);
+    m_dspScratch.resize(kDrainChunk + DspChain::kFrameSize);
+
+    // Pipeline thread: drains the ring, feeds meters and accumulates the take
+    m_pipelineThread = new QThread(this);
+    m_pipelineThread->setObjectName("AudioPipeline");
+    m_drainTimer = new QTimer();
+    m_drainTimer->setInterval(kDrainIntervalMs);
+    m_drainTimer->moveToThread(m_pipelineThread);
+    connect(m_drainTimer, &QTimer::timeout, this, &AudioRecorder::drain, Qt::DirectConnection);
+    connect(m_pipelineThread, &QThread::finished, m_drainTimer, &QObject::deleteLater);
+    m_pipelineThread->start();
+
+    // Capture thread: owns the QAudioSources, so opening a device never blocks the GUI
+    m_captureThread = new QThread(this);
+    m_captureThread->setObjectName("AudioCapture");
+    m_captureContext = new QObject();
+    m_captureContext->moveToThread(m_captureThread);
+    connect(m_captureThread, &QThread::finished, m_captureContext, &QObject::deleteLater);
+    m_captureThread->start(QThread::TimeCriticalPriority);
+
+    // On a hybrid CPU both audio threads live on the efficiency cores, out of
+    // inference's way; the work is light and steady, which is what those cores suit
+    auto pinToEfficiencyCores = []() { CpuTopology::instance().pinCurrentThread(CpuTopology::Efficiency); };
+    QMetaObject::invokeMethod(m_drainTimer, pinToEfficiencyCores);
+    QMetaObject::invokeMethod(m_captureContext, pinToEfficiencyCores);
+
+    m_mediaDevices = new QMediaDevices(this);
+    connect(m_mediaDevices, &QMediaDevices::audioInputsChanged, this, &AudioRecorder::onInputsChanged);
+
+    QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
         qWarning() << "No default audio input device found!";
     }
-    setDevice(currentDevice);
-    open(QIODevice::WriteOnly); // Open the QIODevice after setting up the device
+    requestDevice(device);
+
+    reloadSettings();
 }
 
 AudioRecorder::~AudioRecorder()
 {
+    m_prerollMs = 0;
     stop();
+    QMetaObject::invokeMethod(m_drainTimer, [this]() {
+        if (m_spareJournal) m_spareJournal->markTranscribed(); // Never used, just removes the file
+        m_spareJournal.reset();
+    }, Qt::BlockingQueuedConnection);
+    QMetaObject::invokeMethod(m_captureContext, [this]() {
+        delete m_pending;
+        delete m_sink;
+        m_pending = m_sink = nullptr;
+    }, Qt::BlockingQueuedConnection);
+    m_captureThread->quit();
+    m_captureThread->wait();
+    m_pipelineThread->quit();
+    m_pipelineThread->wait();
 }
 
 QList<QAudioDevice> AudioRecorder::availableDevices()
@@ -20,100 +91,547 @@ QList<QAudioDevice> AudioRecorder::availableDevices()
     return QMediaDevices::audioInputs();
 }
 
+void AudioRecorder::reloadSettings()
+{
+    const bool vadEnabled = DatabaseManager::instance().getSetting("vad_enabled", "1") == "1";
+    const int hangoverMs = DatabaseManager::instance().getSetting("vad_hangover_ms", "300").toInt();
+    const bool journalEnabled = DatabaseManager::instance().getSetting("journal_enabled", "1") == "1";
+    const bool dspEnabled = DatabaseManager::instance().getSetting("dsp_enabled", "0") == "1";
+    QMetaObject::invokeMethod(m_drainTimer, [this, vadEnabled, hangoverMs, journalEnabled, dspEnabled]() {
+        m_vadEnabled = vadEnabled;
+        m_dspEnabled = dspEnabled;
+        m_vad.setHangoverMs(hangoverMs);
+        m_journalEnabled = journalEnabled;
+        prepareSpareJournal();
+    }, Qt::BlockingQueuedConnection);
+
+    setPrerollMs(DatabaseManager::instance().getSetting("preroll_ms", "0").toInt());
+}
+
+void AudioRecorder::setChunkSink(const ChunkSink &sink)
+{
+    QMetaObject::invokeMethod(m_drainTimer, [this, sink]() { m_chunkSink = sink; }, Qt::BlockingQueuedConnection);
+}
+
 void AudioRecorder::setDevice(const QAudioDevice &device)
 {
-    stop(); // Stop any ongoing recording
-    currentDevice = device;
+    // Picking the default keeps following it; anything else pins the choice
+    m_followDefault = (device == QMediaDevices::defaultAudioInput());
+    requestDevice(device);
+}
 
-    // Clear existing audioSource if any
-    if (audioSource) {
-        audioSource->deleteLater(); // Delete the old source
-        audioSource = nullptr;
+void AudioRecorder::requestDevice(const QAudioDevice &device)
+{
+    if (device.isNull() || device == m_requestedDevice) return;
+    m_requestedDevice = device;
+    QMetaObject::invokeMethod(m_captureContext, [this, device]() { prepareDevice(device); });
+}
+
+void AudioRecorder::onInputsChanged()
+{
+    emit inputsChanged();
+
+    const QAudioDevice defaultDevice = QMediaDevices::defaultAudioInput();
+    const bool present = QMediaDevices::audioInputs().contains(m_requestedDevice);
+    if (defaultDevice.isNull() || defaultDevice == m_requestedDevice) return;
+
+    if (!present) {
+        qDebug() << m_requestedDevice.description() << "went away, switching to" << defaultDevice.description();
+        m_followDefault = true;
+        requestDevice(defaultDevice);
+    } else if (m_followDefault) {
+        qDebug() << "Default input changed, switching to" << defaultDevice.description();
+        requestDevice(defaultDevice);
     }
+}
+
+// Capture thread: open the new device off the GUI thread. While capturing,
+// the old source keeps feeding the take until the new one delivers its first
+// buffer, so the switch costs no audio unless the old device is already gone.
+void AudioRecorder::prepareDevice(const QAudioDevice &device)
+{
+    dropPending(); // Superseded by this request
+
+    auto *sink = new AudioCaptureSink(device, [this](const float *samples, int count) {
+        pushCaptured(samples, count);
+    }, m_captureContext);
 
-    format.setSampleRate(16000);
-    format.setChannelCount(1);
-    format.setSampleFormat(QAudioFormat::Float);
+    if (!m_sink || !m_sink->isRunning()) {
+        delete m_sink;
+        m_sink = sink;
+        QMetaObject::invokeMethod(this, [this, device]() {
+            currentDevice = device;
+            emit deviceChanged(device);
+        });
+        return;
+    }
 
-    if (!currentDevice.isFormatSupported(format)) {
-         qWarning() << "Requested format not supported - system may adapt.";
+    sink->setLive(false);
+    connect(sink, &AudioCaptureSink::ready, m_captureContext, [this]() { promotePending(); }, Qt::DirectConnection);
+    m_pending = sink;
+    m_switchStartNs = steadyNowNs();
+    if (!sink->start()) {
+        dropPending();
+        return;
     }
 
-    audioSource = new QAudioSource(currentDevice, format, this);
+    QTimer::singleShot(kSwitchTimeoutMs, sink, [this, sink]() {
+        if (m_pending != sink) return;
+        qWarning() << sink->device().description() << "delivered no audio within" << kSwitchTimeoutMs
+                   << "ms, staying on" << m_sink->device().description();
+        dropPending();
+        const QAudioDevice active = m_sink->device();
+        QMetaObject::invokeMethod(this, [this, active]() {
+            m_requestedDevice = active;
+            emit deviceChanged(active);
+        });
+    });
 }
 
-void AudioRecorder::start()
+// Capture thread, from inside the pending sink's first callback
+void AudioRecorder::promotePending()
 {
-    if (!isOpen()) {
-        open(QIODevice::WriteOnly);
+    if (!m_pending) return;
+
+    AudioCaptureSink *old = m_sink;
+    if (old) {
+        old->setLive(false);
+        old->stop();
+        old->deleteLater();
     }
-    
-    if (audioSource) {
-        m_recordedAudio.clear(); // Clear for new recording
-        audioSource->start(this); 
-        qDebug() << "Audio recording started (accumulation active)";
+    m_sink = m_pending;
+    m_pending = nullptr;
+    m_sink->setLive(true);
+
+    const QAudioDevice device = m_sink->device();
+    qDebug() << "Switched input to" << device.description() << "- ready after"
+             << (steadyNowNs() - m_switchStartNs) / 1e6 << "ms with the old device still recording";
+    QMetaObject::invokeMethod(this, [this, device]() {
+        currentDevice = device;
+        emit deviceChanged(device);
+    });
+}
+
+void AudioRecorder::dropPending()
+{
+    if (!m_pending) return;
+    m_pending->stop();
+    m_pending->deleteLater();
+    m_pending = nullptr;
+}
+
+void AudioRecorder::setPrerollMs(int ms)
+{
+    ms = qBound(0, ms, kMaxPrerollMs);
+    const qint64 samples = qint64(ms) * AudioConverter::kTargetRate / 1000;
+
+    // The pre-roll ring is only touched on the pipeline thread; size it there, once
+    QMetaObject::invokeMethod(m_drainTimer, [this, samples]() {
+        m_preroll = QVector<float>(samples, 0.0f);
+        m_prerollWrite = 0;
+        m_prerollFill = 0;
+    }, Qt::BlockingQueuedConnection);
+    m_prerollMs = ms;
+
+    if (m_takeActive) return; // Takes effect when the current take ends
+
+    if (ms > 0) {
+        if (!m_capturing) {
+            startCapture();
+            QMetaObject::invokeMethod(m_drainTimer, [this]() { m_drainTimer->start(kArmedDrainIntervalMs); });
+        }
+        qDebug() << "Microphone armed:" << ms << "ms pre-roll," << (samples * qint64(sizeof(float))) / 1024
+                 << "KB, drained every" << kArmedDrainIntervalMs << "ms";
+    } else if (m_capturing) {
+        stopCapture();
+        QMetaObject::invokeMethod(m_drainTimer, [this]() {
+            m_drainTimer->stop();
+            drain();
+        }, Qt::BlockingQueuedConnection);
+        qDebug() << "Microphone disarmed";
+    }
+}
+
+void AudioRecorder::startCapture()
+{
+    if (m_capturing) return;
+    bool started = false;
+    QMetaObject::invokeMethod(m_captureContext, [this, &started]() {
+        started = m_sink && m_sink->start();
+    }, Qt::BlockingQueuedConnection);
+    m_capturing = started;
+}
+
+void AudioRecorder::stopCapture()
+{
+    if (!m_capturing) return;
+    double cost = 0.0;
+    QMetaObject::invokeMethod(m_captureContext, [this, &cost]() {
+        promotePending(); // A switch still warming up becomes the device for next time
+        if (!m_sink) return;
+        m_sink->stop();
+        cost = m_sink->converter().microsPerSecondOfAudio();
+        m_sink->converter().resetStats();
+    }, Qt::BlockingQueuedConnection);
+    m_capturing = false;
+
+    if (cost > 0.0) {
+        qDebug() << "Input conversion cost:" << cost << "us per second of audio";
     }
 }
 
+qint64 AudioRecorder::nowNs()
+{
+    return steadyNowNs();
+}
+
+void AudioRecorder::start(qint64 triggerNs)
+{
+    const bool armed = m_capturing; // Already running: the take starts from the pre-roll
+    m_startNs = triggerNs > 0 ? triggerNs : steadyNowNs();
+    m_firstSampleNs = -1;
+    m_awaitingFirstSample = !armed;
+
+    QMetaObject::invokeMethod(m_drainTimer, [this]() { beginTake(); }, Qt::BlockingQueuedConnection);
+    startCapture();
+    qDebug() << "Audio recording started (accumulation active)" << (armed ? "from armed pre-roll" : "");
+}
+
 void AudioRecorder::stop()
 {
-    if (audioSource) audioSource->stop();
-    close();
+    // Stop the source first so endTake() sees every captured sample
+    if (!isArmed()) stopCapture();
+    if (m_pipelineThread->isRunning()) {
+        QMetaObject::invokeMethod(m_drainTimer, [this]() { endTake(); }, Qt::BlockingQueuedConnection);
+    }
 }
 
-QVector<float> AudioRecorder::getRecordedAudio()
+RecordingView AudioRecorder::getRecordedAudio() const
 {
-    return m_recordedAudio;
+    return takeView();
 }
 
-// QAudioSource calls this to write captured audio into our buffer
-qint64 AudioRecorder::writeData(const char *data, qint64 len)
+std::shared_ptr<RecordingJournal> AudioRecorder::journal() const
 {
-    // Convert bytes to float samples
-    // Assuming format is Float, 4 bytes per sample
-    int sampleCount = len / sizeof(float);
-    QVector<float> samples(sampleCount);
-    
-    // Copy data and calculate overall level
-    const float *ptr = reinterpret_cast<const float*>(data);
-    float maxAmp = 0.0f;
-    for (int i = 0; i < sampleCount; ++i) {
-        samples[i] = ptr[i];
-        float val = std::abs(ptr[i]);
-        if (val > maxAmp) maxAmp = val;
-    }
-    
-    // Simple frequency band approximation using sample ranges
-    // Divide samples into 6 bands (low to high frequency)
-    QVector<float> bands(6, 0.0f);
-    int samplesPerBand = sampleCount / 6;
-    
-    for (int band = 0; band < 6; band++) {
-        float bandMax = 0.0f;
-        int startIdx = band * samplesPerBand;
-        int endIdx = (band + 1) * samplesPerBand;
-        
-        for (int i = startIdx; i < endIdx && i < sampleCount; ++i) {
-            float val = std::abs(ptr[i]);
-            if (val > bandMax) bandMax = val;
+    QMutexLocker locker(&m_journalMutex);
+    return m_journal;
+}
+
+RecordingView AudioRecorder::takeView() const
+{
+    std::shared_ptr<RecordingJournal> journal = this->journal();
+    if (!journal) return m_recording.view();
+
+    // Journal first; RAM holds whatever came after it failed, if anything
+    RecordingView view = journal->view();
+    for (const RecordingView::Span &span : m_recording.view().spans()) view.appendSpan(span);
+    return view;
+}
+
+RecordingView AudioRecorder::getSpeechAudio() const
+{
+    RecordingView recording = takeView();
+    VoiceActivityDetector::Segment bounds;
+    {
+        QMutexLocker locker(&m_journalMutex);
+        if (!m_hasSpeechBounds) return recording;
+        bounds = m_speechBounds;
+    }
+    RecordingView speech = recording.mid(bounds.start, bounds.end - bounds.start);
+    qDebug() << "VAD: kept" << speech.durationSeconds() << "s of" << recording.durationSeconds()
+             << "s, trimmed" << (recording.durationSeconds() - speech.durationSeconds()) << "s of silence";
+    return speech;
+}
+
+// Capture thread: the live sink's output. Real-time path, never allocates.
+void AudioRecorder::pushCaptured(const float *samples, int count)
+{
+    if (m_awaitingFirstSample.load(std::memory_order_relaxed)) {
+        m_awaitingFirstSample.store(false, std::memory_order_relaxed);
+        m_firstSampleNs.store(steadyNowNs(), std::memory_order_relaxed);
+    }
+    m_ring.write(samples, count);
+}
+
+// Pipeline thread: start a take, splicing the armed pre-roll onto its front
+void AudioRecorder::beginTake()
+{
+    drain(); // Anything queued before the hotkey still belongs to the pre-roll
+
+    m_recording.clear(); // Clear for new recording
+    m_spectrum.reset();
+    std::fill(m_meterBands, m_meterBands + MeterSnapshot::kBands, 0.0f);
+    m_meterHasBands = false;
+    m_vad.reset();
+    m_takeSamples = 0;
+    m_chunkingActive = m_chunkingEnabled && m_chunkSink;
+    m_chunkStart = -1;
+    m_lastCut = 0;
+    m_chunkOverlapped = false;
+    m_segmentsSeen = 0;
+    m_dspActive = m_dspEnabled; // Latched per take, so a settings change can't cut the DSP tail
+    if (m_dspActive) {
+        m_dsp.reset();
+        m_dsp.resetStats();
+    }
+    {
+        QMutexLocker locker(&m_journalMutex);
+        m_journal = m_journalEnabled ? std::move(m_spareJournal) : nullptr;
+        m_spareJournal.reset();
+        m_hasSpeechBounds = false;
+    }
+
+    const qint64 splicedMs = m_prerollFill * 1000 / AudioConverter::kTargetRate;
+    if (m_prerollFill > 0) {
+        const qint64 size = m_preroll.size();
+        const qint64 start = (m_prerollWrite - m_prerollFill + size) % size;
+        const qint64 first = qMin(m_prerollFill, size - start);
+        const float *parts[2] = { m_preroll.constData() + start, m_preroll.constData() };
+        const qint64 lengths[2] = { first, m_prerollFill - first };
+        for (int i = 0; i < 2; ++i) {
+            if (lengths[i] <= 0) continue;
+            processTake(parts[i], lengths[i]);
         }
-        
-        // Add some variation based on band index for more natural look
-        float multiplier = 1.0f + (band * 0.1f); // Higher bands get slight boost
-        bands[band] = bandMax * multiplier;
+        m_prerollFill = 0;
+        m_prerollWrite = 0;
     }
-    
-    emit audioLevel(maxAmp);
-    emit frequencyBands(bands);
-    emit audioAvailable(samples);
-    
-    // ACCUMULATE EVERYTHING FOR FINAL TRANSCRIPTION
-    m_recordedAudio.append(samples);
-    
-    return len;
+    if (!m_awaitingFirstSample) {
+        // Armed: the take's first sample predates the hotkey, so what's left is
+        // the time until the pre-roll became the take
+        qDebug() << "Hotkey-to-take latency:" << (steadyNowNs() - m_startNs) / 1e6 << "ms (armed," << splicedMs
+                 << "ms of pre-roll spliced)";
+    }
+
+    m_takeActive = true;
+    m_drainTimer->start(kDrainIntervalMs);
 }
 
-qint64 AudioRecorder::readData(char *data, qint64 maxlen)
+// Pipeline thread: finish the take; keep feeding the pre-roll while armed
+void AudioRecorder::endTake()
 {
-    return 0; // We don't read from here
+    drain();
+    if (m_dspActive) {
+        // The STFT holds back up to one frame; push it out before closing the take
+        const int tail = m_dsp.flush(m_dspScratch.data());
+        if (m_vadEnabled) m_vad.process(m_dspScratch.constData(), tail);
+        appendToTake(m_dspScratch.constData(), tail);
+        qDebug() << "DSP front-end cost:" << m_dsp.microsPerSecondOfAudio() << "us per second of audio";
+        m_dspActive = false;
+    }
+    m_vad.finish();
+    if (m_chunkingActive) cutChunks(true);
+    m_takeActive = false;
+    if (m_vadEnabled) {
+        QMutexLocker locker(&m_journalMutex);
+        m_speechBounds = m_vad.speechBounds(kSpeechPaddingMs);
+        m_hasSpeechBounds = true;
+    }
+
+    if (std::shared_ptr<RecordingJournal> journal = this->journal()) {
+        journal->finish();
+        qDebug() << "Journaled" << journal->size() / double(AudioConverter::kTargetRate) << "s to" << journal->path();
+    }
+    // Next take's file, created now so start() doesn't pay for it
+    QMetaObject::invokeMethod(m_drainTimer, [this]() { prepareSpareJournal(); }, Qt::QueuedConnection);
+
+    if (m_prerollMs > 0 && m_capturing) {
+        m_drainTimer->start(kArmedDrainIntervalMs);
+    } else {
+        m_drainTimer->stop();
+    }
+}
+
+// Pipeline thread: optional DSP clean-up, then VAD and the take itself.
+// Meters stay on the raw signal, so they show what the microphone hears.
+void AudioRecorder::processTake(const float *data, qint64 count)
+{
+    while (count > 0) {
+        const int chunk = int(qMin<qint64>(count, kDrainChunk));
+        const float *samples = data;
+        int produced = chunk;
+        if (m_dspActive) {
+            produced = m_dsp.process(data, chunk, m_dspScratch.data());
+            samples = m_dspScratch.constData();
+        }
+        if (m_vadEnabled) m_vad.process(samples, produced);
+        appendToTake(samples, produced);
+        if (m_chunkingActive) cutChunks(false);
+        data += chunk;
+        count -= chunk;
+    }
+}
+
+// Pipeline thread: the journal takes the samples; RAM only if it can't
+void AudioRecorder::appendToTake(const float *data, qint64 count)
+{
+    m_takeSamples += count;
+    if (m_journal && m_recording.size() == 0 && m_journal->append(data, count)) return;
+    if (m_journal && m_recording.size() == 0) {
+        qWarning() << "Recording journal unavailable, keeping the rest of the take in memory";
+    }
+    m_recording.append(data, count);
+}
+
+// Pipeline thread: close the open chunk at the first pause after it has
+// reached kMinChunkMs, or inside speech once it reaches kMaxChunkMs. Between
+// chunks nothing is sent until the VAD hears speech again.
+void AudioRecorder::cutChunks(bool endOfTake)
+{
+    const qint64 rate = AudioConverter::kTargetRate;
+    const qint64 padding = kSpeechPaddingMs * rate / 1000;
+
+    if (!m_vadEnabled) {
+        // No pauses to cut at: fixed-length chunks with overlap, the tail on stop
+        if (m_chunkStart < 0) m_chunkStart = 0;
+        if (endOfTake) {
+            if (m_takeSamples > m_chunkStart) emitChunk(m_takeSamples, m_chunkOverlapped);
+        } else if (m_takeSamples - m_chunkStart >= kMaxChunkMs * rate / 1000) {
+            emitChunk(m_takeSamples, m_chunkOverlapped);
+            m_chunkStart = m_takeSamples - kChunkOverlapMs * rate / 1000;
+            m_chunkOverlapped = true;
+        }
+        return;
+    }
+
+    const std::vector<VoiceActivityDetector::Segment> &segments = m_vad.segments();
+    if (m_chunkStart < 0) {
+        // Idle since the last cut: open a chunk a little before speech resumes
+        qint64 speechStart = -1;
+        if (m_segmentsSeen < segments.size()) speechStart = segments[m_segmentsSeen].start;
+        else if (m_vad.inSpeech()) speechStart = m_vad.openSegmentStart();
+        if (speechStart >= 0) {
+            m_chunkStart = qMax(m_lastCut, speechStart - padding);
+            m_chunkOverlapped = false;
+        }
+    }
+    if (m_chunkStart < 0) {
+        m_segmentsSeen = segments.size();
+        return;
+    }
+
+    if (endOfTake) {
+        // finish() closed any open segment; stop at the last speech plus padding
+        const qint64 end = qMin(m_takeSamples, m_vad.speechBounds(kSpeechPaddingMs).end);
+        if (end > m_chunkStart) emitChunk(end, m_chunkOverlapped);
+        return;
+    }
+
+    if (m_segmentsSeen < segments.size()) {
+        // A pause ended a segment; its end already carries the VAD hangover as padding
+        const qint64 end = segments.back().end;
+        m_segmentsSeen = segments.size();
+        if (end - m_chunkStart >= kMinChunkMs * rate / 1000) {
+            emitChunk(end, m_chunkOverlapped);
+            m_chunkStart = -1;
+            return;
+        }
+    }
+
+    if (m_takeSamples - m_chunkStart >= kMaxChunkMs * rate / 1000) {
+        // No pause long enough: cut inside speech and let the next chunk re-hear the edge
+        emitChunk(m_takeSamples, m_chunkOverlapped);
+        m_chunkStart = m_takeSamples - kChunkOverlapMs * rate / 1000;
+        m_chunkOverlapped = true;
+    }
+}
+
+void AudioRecorder::emitChunk(qint64 end, bool overlapped)
+{
+    const RecordingView chunk = takeView().mid(m_chunkStart, end - m_chunkStart);
+    m_lastCut = end;
+    qDebug() << "Chunk ready:" << chunk.durationSeconds() << "s at" << m_chunkStart / double(AudioConverter::kTargetRate) << "s";
+    m_chunkSink(chunk, overlapped);
+}
+
+// Pipeline thread
+void AudioRecorder::prepareSpareJournal()
+{
+    if (!m_journalEnabled && m_spareJournal) {
+        m_spareJournal->markTranscribed(); // Unused, just removes the file
+        m_spareJournal.reset();
+    }
+    if (!m_journalEnabled || m_spareJournal || m_takeActive) return;
+    m_spareJournal = RecordingJournal::create(RecordingJournal::defaultDirectory(), AudioConverter::kTargetRate);
+}
+
+// Pipeline thread: keep only the newest pre-roll-length of audio
+void AudioRecorder::pushPreroll(const float *data, qint64 count)
+{
+    const qint64 size = m_preroll.size();
+    if (size == 0) return;
+    if (count > size) {
+        data += count - size;
+        count = size;
+    }
+    const qint64 first = qMin(count, size - m_prerollWrite);
+    memcpy(m_preroll.data() + m_prerollWrite, data, first * sizeof(float));
+    memcpy(m_preroll.data(), data + first, (count - first) * sizeof(float));
+    m_prerollWrite = (m_prerollWrite + count) % size;
+    m_prerollFill = qMin(size, m_prerollFill + count);
+}
+
+// Pipeline thread: move samples out of the ring, update meters, accumulate
+void AudioRecorder::drain()
+{
+    size_t count;
+    if (!m_takeActive) {
+        // Armed between takes: no meters, no analysis, just the bounded pre-roll
+        while ((count = m_ring.read(m_drainScratch.data(), m_drainScratch.size())) > 0) {
+            pushPreroll(m_drainScratch.constData(), qint64(count));
+        }
+        return;
+    }
+
+    const qint64 firstSampleNs = m_firstSampleNs.exchange(-1);
+    if (firstSampleNs >= 0) {
+        qDebug() << "Hotkey-to-first-sample latency:" << (firstSampleNs - m_startNs) / 1e6 << "ms";
+    }
+
+    float maxAmp = 0.0f;
+    float sumSquares = 0.0f;
+    const bool metering = m_meteringActive.load(std::memory_order_relaxed);
+    const bool wantsSamples = isSignalConnected(QMetaMethod::fromSignal(&AudioRecorder::audioAvailable));
+    size_t total = 0;
+
+    while ((count = m_ring.read(m_drainScratch.data(), m_drainScratch.size())) > 0) {
+        const float *ptr = m_drainScratch.constData();
+        total += count;
+
+        for (size_t i = 0; i < count; ++i) {
+            float val = std::abs(ptr[i]);
+            if (val > maxAmp) maxAmp = val;
+            sumSquares += ptr[i] * ptr[i];
+        }
+
+        // Real log-spaced spectrum (windowed FFT), only while someone is looking
+        if (metering && m_spectrum.process(ptr, int(count))) {
+            const int bands = qMin(m_spectrum.bandCount(), int(MeterSnapshot::kBands));
+            std::copy(m_spectrum.bands(), m_spectrum.bands() + bands, m_meterBands);
+            m_meterHasBands = true;
+        }
+
+        if (wantsSamples) {
+            emit audioAvailable(QVector<float>(ptr, ptr + count));
+        }
+
+        // ACCUMULATE EVERYTHING FOR FINAL TRANSCRIPTION
+        processTake(ptr, qint64(count));
+    }
+
+    const quint64 dropped = m_ring.droppedSamples();
+    if (dropped != m_reportedDrops) {
+        qWarning() << "Audio pipeline fell behind, dropped" << (dropped - m_reportedDrops) << "samples";
+        m_reportedDrops = dropped;
+    }
+
+    // One snapshot per drain interval, aggregated over everything drained
+    if (total > 0) {
+        MeterSnapshot &meter = m_meter.writeBuffer();
+        meter.peak = maxAmp;
+        meter.rms = std::sqrt(sumSquares / float(total));
+        std::copy(m_meterBands, m_meterBands + MeterSnapshot::kBands, meter.bands);
+        meter.hasBands = m_meterHasBands;
+        meter.sequence = ++m_meterSequence;
+        m_meter.publish();
+    }
 }
@@ -0,0 +1,65 @@
+#include "audioringbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+static size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+AudioRingBuffer::AudioRingBuffer(size_t capacity)
+    : m_capacity(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)))
+{
+    m_mask = m_capacity - 1;
+    m_buffer.reset(new float[m_capacity]());
+}
+
+size_t AudioRingBuffer::write(const float *data, size_t count)
+{
+    const size_t writePos = m_writePos.load(std::memory_order_relaxed);
+    const size_t readPos = m_readPos.load(std::memory_order_acquire);
+
+    const size_t freeSpace = m_capacity - (writePos - readPos);
+    const size_t toWrite = std::min(count, freeSpace);
+    if (toWrite < count) {
+        m_dropped.fetch_add(count - toWrite, std::memory_order_relaxed);
+    }
+    if (toWrite == 0) return 0;
+
+    // Copy in at most two pieces (before and after the wrap point)
+    const size_t start = writePos & m_mask;
+    const size_t firstPart = std::min(toWrite, m_capacity - start);
+    std::memcpy(m_buffer.get() + start, data, firstPart * sizeof(float));
+    if (toWrite > firstPart) {
+        std::memcpy(m_buffer.get(), data + firstPart, (toWrite - firstPart) * sizeof(float));
+    }
+
+    m_writePos.store(writePos + toWrite, std::memory_order_release);
+    return toWrite;
+}
+
+size_t AudioRingBuffer::read(float *dest, size_t maxCount)
+{
+    const size_t readPos = m_readPos.load(std::memory_order_relaxed);
+    const size_t writePos = m_writePos.load(std::memory_order_acquire);
+
+    const size_t toRead = std::min(maxCount, writePos - readPos);
+    if (toRead == 0) return 0;
+
+    const size_t start = readPos & m_mask;
+    const size_t firstPart = std::min(toRead, m_capacity - start);
+    std::memcpy(dest, m_buffer.get() + start, firstPart * sizeof(float));
+    if (toRead > firstPart) {
+        std::memcpy(dest + firstPart, m_buffer.get(), (toRead - firstPart) * sizeof(float));
+    }
+
+    m_readPos.store(readPos + toRead, std::memory_order_release);
+    return toRead;
+}
+
+size_t AudioRingBuffer::available() const
+{
+    return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_acquire);
+}
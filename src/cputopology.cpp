@@ -0,0 +1,200 @@
+#include "cputopology.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <sched.h>
+#include <unistd.h>
+
+static const double kFastShare = 0.8; // Within 80% of the fastest core's capacity or clock counts as fast
+static const int kSampleMs = 50;
+static const double kBusyShare = 0.1; // A thread must be on CPU for 10% of the job to count
+
+static QString readSysfs(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    return QString::fromLatin1(file.readAll()).trimmed();
+}
+
+static QVector<int> allowedCpus()
+{
+    QVector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.append(cpu);
+        }
+    }
+    return cpus;
+}
+
+// The first call captures the process's allowed CPUs, so make it before any pinning
+const CpuTopology &CpuTopology::instance()
+{
+    static const CpuTopology topology;
+    return topology;
+}
+
+CpuTopology::CpuTopology()
+{
+    const QVector<int> allowed = allowedCpus();
+    if (!detectIntelHybrid(allowed)
+        && !detectByValue(allowed, "cpu_capacity", "cpu_capacity")
+        && !detectByValue(allowed, "cpufreq/cpuinfo_max_freq", "cpufreq")) {
+        m_performance = allowed;
+        m_efficiency.clear();
+        m_source = "homogeneous";
+    }
+    qDebug() << "CPU topology:" << describe();
+}
+
+bool CpuTopology::detectIntelHybrid(const QVector<int> &allowed)
+{
+    const QVector<int> core = parseCpuList(readSysfs("/sys/devices/cpu_core/cpus"));
+    const QVector<int> atom = parseCpuList(readSysfs("/sys/devices/cpu_atom/cpus"));
+    for (int cpu : allowed) {
+        if (core.contains(cpu)) m_performance.append(cpu);
+        else if (atom.contains(cpu)) m_efficiency.append(cpu);
+    }
+    m_source = "cpu_core/cpu_atom";
+    // Restricted to one kind (taskset, cgroups), or a CPU the lists don't cover: not hybrid for us
+    return !m_performance.isEmpty() && !m_efficiency.isEmpty()
+        && m_performance.size() + m_efficiency.size() == allowed.size();
+}
+
+// Split on a per-CPU sysfs number: capacity on ARM, max clock elsewhere
+bool CpuTopology::detectByValue(const QVector<int> &allowed, const QString &file, const QString &source)
+{
+    m_performance.clear();
+    m_efficiency.clear();
+    QHash<int, qint64> values;
+    qint64 fastest = 0;
+    for (int cpu : allowed) {
+        bool ok = false;
+        const qint64 value = readSysfs(QString("/sys/devices/system/cpu/cpu%1/%2").arg(cpu).arg(file)).toLongLong(&ok);
+        if (!ok || value <= 0) return false; // Missing for any CPU: don't guess
+        values.insert(cpu, value);
+        fastest = qMax(fastest, value);
+    }
+    for (int cpu : allowed) {
+        (values.value(cpu) >= fastest * kFastShare ? m_performance : m_efficiency).append(cpu);
+    }
+    m_source = source;
+    return !m_performance.isEmpty() && !m_efficiency.isEmpty();
+}
+
+QString CpuTopology::describe() const
+{
+    if (!isHybrid()) return QString("homogeneous, %1 CPUs").arg(m_performance.size());
+    return QString("hybrid (%1): P %2, E %3").arg(m_source, formatCpuList(m_performance), formatCpuList(m_efficiency));
+}
+
+QString CpuTopology::classify(const QVector<int> &cpus) const
+{
+    if (cpus.isEmpty()) return "unknown";
+    if (!isHybrid()) return formatCpuList(cpus);
+    QVector<int> fast, slow;
+    for (int cpu : cpus) (m_efficiency.contains(cpu) ? slow : fast).append(cpu);
+    QStringList parts;
+    if (!fast.isEmpty()) parts << "P " + formatCpuList(fast);
+    if (!slow.isEmpty()) parts << "E " + formatCpuList(slow);
+    return parts.join(' ');
+}
+
+bool CpuTopology::pinCurrentThread(CoreClass coreClass) const
+{
+    if (!isHybrid()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : coreClass == Performance ? m_performance : m_efficiency) CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) { // 0: the calling thread
+        qWarning() << "Could not pin thread to" << (coreClass == Performance ? "performance" : "efficiency") << "cores";
+        return false;
+    }
+    return true;
+}
+
+QVector<int> CpuTopology::parseCpuList(const QString &list)
+{
+    QVector<int> cpus;
+    for (const QString &range : list.split(',', Qt::SkipEmptyParts)) {
+        const QStringList bounds = range.trimmed().split('-');
+        bool okFrom = false, okTo = false;
+        const int from = bounds.first().toInt(&okFrom);
+        const int to = bounds.size() > 1 ? bounds.at(1).toInt(&okTo) : from;
+        if (!okFrom || (bounds.size() > 1 && !okTo)) continue;
+        for (int cpu = from; cpu <= to; ++cpu) cpus.append(cpu);
+    }
+    return cpus;
+}
+
+QString CpuTopology::formatCpuList(QVector<int> cpus)
+{
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    QStringList ranges;
+    for (int i = 0; i < cpus.size();) {
+        int j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        ranges << (j == i ? QString::number(cpus[i]) : QString("%1-%2").arg(cpus[i]).arg(cpus[j]));
+        i = j + 1;
+    }
+    return ranges.join(',');
+}
+
+void CoreUsageProbe::begin()
+{
+    m_ticks.clear();
+    m_busyTicks.clear();
+    m_cpus.clear();
+    m_started.start();
+    read();
+    m_busyTicks.clear(); // The first read is only the baseline
+    m_cpus.clear();
+}
+
+void CoreUsageProbe::sample()
+{
+    if (m_lastRead.isValid() && m_lastRead.elapsed() < kSampleMs) return;
+    read();
+}
+
+// Threads that appear mid-job (ggml's workers) start from zero
+void CoreUsageProbe::read()
+{
+    m_lastRead.start();
+    const QStringList tasks = QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &task : tasks) {
+        QFile file("/proc/self/task/" + task + "/stat");
+        if (!file.open(QIODevice::ReadOnly)) continue; // Thread already gone
+        const QByteArray stat = file.readAll();
+        // The thread name may contain spaces; fields after it are fixed
+        const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() < 37) continue;
+        const qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong(); // utime + stime
+        const int cpu = fields.at(36).toInt();                                        // Last CPU run on
+
+        const int tid = task.toInt();
+        const qint64 delta = ticks - m_ticks.value(tid, 0);
+        m_ticks.insert(tid, ticks);
+        if (delta > 0) {
+            m_busyTicks[tid] += delta;
+            m_cpus[tid].insert(cpu);
+        }
+    }
+}
+
+QVector<int> CoreUsageProbe::end()
+{
+    read();
+    const qint64 ticksPerSecond = sysconf(_SC_CLK_TCK);
+    const qint64 threshold = qMax<qint64>(1, qint64(m_started.elapsed() * ticksPerSecond * kBusyShare / 1000));
+
+    QSet<int> cpus;
+    for (auto it = m_busyTicks.constBegin(); it != m_busyTicks.constEnd(); ++it) {
+        if (it.value() >= threshold) cpus.unite(m_cpus.value(it.key()));
+    }
+    return QVector<int>(cpus.begin(), cpus.end());
+}
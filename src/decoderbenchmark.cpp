@@ -0,0 +1,253 @@
+#include "decoderbenchmark.h"
+#include "audioconverter.h"
+#include "cputopology.h"
+#include "databasemanager.h"
+#include "decodingpolicy.h"
+#include "inferenceworker.h"
+#include "longformtranscriber.h"
+#include "modelcatalog.h"
+#include "modelfile.h"
+#include "wavfile.h"
+#include "whisperstatepool.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
+#include <atomic>
+#include <climits>
+
+namespace {
+
+struct Clip {
+    QString name;
+    QVector<float> pcm;
+    QString reference; // Empty if there is no transcript
+};
+
+} // namespace
+
+bool DecoderBenchmark::openSettings()
+{
+    static const bool open = DatabaseManager::instance().init();
+    return open;
+}
+
+QString DecoderBenchmark::resolveModel(const QString &modelPath)
+{
+    QString model = modelPath;
+    if (model.isEmpty() && openSettings()) {
+        model = DatabaseManager::instance().getSetting("model_path");
+    }
+    if (model.isEmpty() || !QFile::exists(model)) {
+        model = QCoreApplication::applicationDirPath() + "/models/ggml-base.en.bin";
+    }
+    return model;
+}
+
+int DecoderBenchmark::runAudioContext(const QString &corpusDir, const QString &modelPath)
+{
+    QTextStream out(stdout);
+    const int rate = AudioConverter::kTargetRate;
+
+    // Clips: a corpus of .wav files with optional same-named .txt transcripts,
+    // or else the reference clip and its first 2, 4, 6 and 8 seconds
+    QVector<Clip> clips;
+    if (!corpusDir.isEmpty()) {
+        const QDir dir(corpusDir);
+        for (const QString &name : dir.entryList({"*.wav"}, QDir::Files, QDir::Name)) {
+            Clip clip;
+            clip.name = name;
+            if (!WavFile::load(dir.filePath(name), clip.pcm) || clip.pcm.isEmpty()) continue;
+            QFile text(dir.filePath(QFileInfo(name).completeBaseName() + ".txt"));
+            if (text.open(QIODevice::ReadOnly)) clip.reference = QString::fromUtf8(text.readAll()).trimmed();
+            clips.append(clip);
+        }
+    } else {
+        const ModelCatalog::Reference reference = ModelCatalog::referenceClip();
+        if (reference.isValid()) {
+            for (int seconds : {2, 4, 6, 8}) {
+                clips.append({QString("reference, first %1 s").arg(seconds), reference.pcm.mid(0, seconds * rate), QString()});
+            }
+            clips.append({"reference, whole", reference.pcm, reference.text});
+        }
+    }
+    if (clips.isEmpty()) {
+        out << "No clips: pass a folder of .wav files, or install the reference clip\n";
+        return 1;
+    }
+
+    const QString model = resolveModel(modelPath);
+    ModelFile file;
+    const std::shared_ptr<WhisperStatePool> pool = file.open(model, true) ? WhisperStatePool::load(file, 1) : nullptr;
+    if (!pool) {
+        out << "Could not load model " << model << "\n";
+        return 1;
+    }
+    WhisperStatePool::Lease lease = pool->acquire();
+    whisper_context *ctx = pool->context();
+    whisper_state *state = lease.state();
+    CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+
+    // Same decode as a final job, without fallbacks so both sides do equal work
+    DecodingPolicy full;
+    full.maxFallbacks = 0;
+    full.budgetMs = 0;
+    DecodingPolicy sized = full;
+    sized.dynamicAudioCtx = true;
+
+    const whisper_full_params wparams = full.params(openSettings() ? InferenceWorker::configuredThreads()
+                                                                   : qMin(4, CpuTopology::instance().computeCpuCount()));
+
+    // Best of three encoder times; the transcript of the last run
+    auto run = [&](const DecodingPolicy &policy, const Clip &clip, DecodingPolicy::Result &best) {
+        for (int i = 0; i < 3; ++i) {
+            DecodingPolicy::Result result;
+            if (!policy.decode(ctx, state, wparams, clip.pcm.constData(), int(clip.pcm.size()), result)) return false;
+            if (i == 0 || result.encodeMs < best.encodeMs) best = result;
+            best.text = result.text;
+        }
+        return true;
+    };
+    DecodingPolicy::Result warmup;
+    run(full, clips.first(), warmup); // Page in the weights before anything is timed
+
+    struct Bucket { const char *name; int upToMs; int clips = 0; double fullMs = 0, sizedMs = 0, agreement = 0; };
+    Bucket buckets[] = {{"0-2 s", 2000}, {"2-4 s", 4000}, {"4-6 s", 6000}, {"6-8 s", 8000}, {"8-10 s", 10000}, {"over 10 s", INT_MAX}};
+
+    out << "Encoder context sized to the clip vs. the full 30 s window (" << QFileInfo(model).fileName() << ", "
+        << wparams.n_threads << " threads)\n";
+    for (const Clip &clip : clips) {
+        DecodingPolicy::Result fullResult, sizedResult;
+        if (!run(full, clip, fullResult) || !run(sized, clip, sizedResult)) {
+            out << "  " << clip.name << ": decode failed\n";
+            continue;
+        }
+        const int clipMs = int(qint64(clip.pcm.size()) * 1000 / rate);
+        // Accuracy check: the sized transcript against the full-window one, and
+        // both against the reference when there is one
+        const double agreement = ModelCatalog::wordAccuracy(fullResult.text, sizedResult.text);
+        out << QString("  %1  %2 s  audio_ctx %3  encoder %4 -> %5 ms  agreement %6%")
+                   .arg(clip.name, -28)
+                   .arg(clipMs / 1000.0, 5, 'f', 1)
+                   .arg(sizedResult.audioCtx > 0 ? sizedResult.audioCtx : 1500, 4)
+                   .arg(fullResult.encodeMs, 7, 'f', 0)
+                   .arg(sizedResult.encodeMs, 7, 'f', 0)
+                   .arg(agreement, 0, 'f', 0);
+        if (!clip.reference.isEmpty()) {
+            out << QString("  accuracy %1% -> %2%")
+                       .arg(ModelCatalog::wordAccuracy(clip.reference, fullResult.text), 0, 'f', 0)
+                       .arg(ModelCatalog::wordAccuracy(clip.reference, sizedResult.text), 0, 'f', 0);
+        }
+        out << "\n";
+        if (agreement < 100.0) {
+            out << "      full:  " << fullResult.text << "\n      sized: " << sizedResult.text << "\n";
+        }
+        out.flush();
+
+        for (Bucket &bucket : buckets) {
+            if (clipMs > bucket.upToMs) continue;
+            ++bucket.clips;
+            bucket.fullMs += fullResult.encodeMs;
+            bucket.sizedMs += sizedResult.encodeMs;
+            bucket.agreement += agreement;
+            break;
+        }
+    }
+
+    out << "\nPer clip length (mean encoder time, full -> sized)\n";
+    for (const Bucket &bucket : buckets) {
+        if (bucket.clips == 0) continue;
+        out << QString("  %1  %2 clips  %3 -> %4 ms  (-%5%)  agreement %6%\n")
+                   .arg(QString(bucket.name), -10)
+                   .arg(bucket.clips, 3)
+                   .arg(bucket.fullMs / bucket.clips, 7, 'f', 0)
+                   .arg(bucket.sizedMs / bucket.clips, 7, 'f', 0)
+                   .arg(bucket.fullMs > 0 ? 100.0 * (1.0 - bucket.sizedMs / bucket.fullMs) : 0.0, 0, 'f', 0)
+                   .arg(bucket.agreement / bucket.clips, 0, 'f', 0);
+    }
+    out.flush();
+    return 0;
+}
+
+int DecoderBenchmark::runLongForm(const QString &wavPath, const QString &modelPath)
+{
+    QTextStream out(stdout);
+    const int rate = AudioConverter::kTargetRate;
+
+    QVector<float> pcm;
+    QString reference;
+    if (!wavPath.isEmpty()) {
+        if (!WavFile::load(wavPath, pcm) || pcm.isEmpty()) {
+            out << "Could not read " << wavPath << "\n";
+            return 1;
+        }
+    } else {
+        const ModelCatalog::Reference clip = ModelCatalog::referenceClip();
+        if (!clip.isValid()) {
+            out << "Reference clip not found; pass a .wav file\n";
+            return 1;
+        }
+        for (int i = 0; i < 8; ++i) { // ~100 s, a second of silence between repeats
+            pcm += clip.pcm;
+            pcm += QVector<float>(rate, 0.0f);
+            reference += clip.text + " ";
+        }
+    }
+    if (pcm.size() <= LongFormTranscriber::kMinSamples) {
+        out << "The recording is under " << LongFormTranscriber::kMinSamples / rate << " s and would not be split\n";
+        return 1;
+    }
+
+    const QString model = resolveModel(modelPath);
+    ModelFile file;
+    const std::shared_ptr<WhisperStatePool> pool = file.open(model, true)
+        ? WhisperStatePool::load(file, LongFormTranscriber::kMaxParallel) : nullptr;
+    if (!pool) {
+        out << "Could not load model " << model << "\n";
+        return 1;
+    }
+    CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+
+    RecordingBuffer buffer;
+    buffer.append(pcm.constData(), pcm.size());
+    const RecordingView audio = buffer.view();
+    const QVector<LongFormTranscriber::Chunk> chunks = LongFormTranscriber::split(audio);
+    int hardCuts = 0;
+    for (const LongFormTranscriber::Chunk &chunk : chunks) hardCuts += chunk.overlapped ? 1 : 0;
+
+    const int cores = CpuTopology::instance().computeCpuCount();
+    out << "Long-form decode of " << pcm.size() / rate << " s (" << QFileInfo(model).fileName() << ", " << cores
+        << " cores): " << chunks.size() << " chunks, " << hardCuts << " cut inside speech\n";
+
+    DecodingPolicy policy;
+    policy.budgetMs = 0; // Same work at every width
+    whisper_full_params wparams = policy.params(cores);
+    wparams.no_context = true;
+
+    std::atomic<bool> cancel{false};
+    qint64 serialMs = 0;
+    {
+        WhisperStatePool::Lease lease = pool->acquire();
+        LongFormTranscriber::Stats warmup;
+        LongFormTranscriber::transcribe(*pool, lease.state(), audio, policy, wparams, 1, &cancel, &warmup); // Page in the weights
+        for (int parallel = 1; parallel <= qMin(LongFormTranscriber::kMaxParallel, cores); parallel *= 2) {
+            wparams.n_threads = qMax(1, cores / parallel);
+            LongFormTranscriber::Stats stats;
+            const QString text = LongFormTranscriber::transcribe(*pool, lease.state(), audio, policy, wparams, parallel,
+                                                                 &cancel, &stats);
+            if (parallel == 1) serialMs = stats.ms;
+            out << QString("  %1 at a time x %2 threads  %3 ms  %4x real time  speedup %5x")
+                       .arg(stats.parallel)
+                       .arg(stats.threadsPerChunk, 2)
+                       .arg(stats.ms, 7)
+                       .arg(stats.ms > 0 ? 1000.0 * pcm.size() / rate / stats.ms : 0.0, 5, 'f', 1)
+                       .arg(stats.ms > 0 ? double(serialMs) / stats.ms : 0.0, 0, 'f', 2);
+            if (!reference.isEmpty()) out << QString("  accuracy %1%").arg(ModelCatalog::wordAccuracy(reference, text), 0, 'f', 0);
+            out << "\n";
+            out.flush();
+        }
+    }
+    return 0; // The pool frees the context and its states
+}
@@ -0,0 +1,255 @@
+#include "decodingpolicy.h"
+#include "databasemanager.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <cmath>
+#include <vector>
+
+static const int kSamplesPerTick = 160;       // whisper timestamps are in 10 ms units at 16 kHz
+static const int kWindowSamples = 30 * 16000; // whisper decodes in 30 s windows
+static const int kMinSamples = 16000 + 1600;  // whisper skips input under a second
+static const float kTemperatureStep = 0.2f;   // Same steps as whisper's own fallback
+static const int kMinEntropyTokens = 16;      // Shorter segments can't show a repetition loop
+static const int kShortClipSamples = 10 * 16000; // Up to here the encoder is sized to the clip
+static const int kSamplesPerPosition = 320;   // One encoder position per 20 ms
+static const int kFullAudioCtx = 1500;
+static const int kAudioCtxMarginMs = 1000;    // Plus 10%: the model never saw inputs cut right at the speech
+static const int kAudioCtxAlign = 64;
+
+namespace {
+
+struct Segment {
+    QString text;
+    int64_t t0 = 0;
+    int64_t t1 = 0;
+    double logprob = 0.0; // Mean over text tokens
+    double entropy = 0.0; // Of the token distribution, in nats
+    int tokens = 0;
+};
+
+Segment readSegment(whisper_context *ctx, whisper_state *state, int index)
+{
+    Segment segment;
+    segment.text = QString::fromUtf8(whisper_full_get_segment_text_from_state(state, index));
+    segment.t0 = whisper_full_get_segment_t0_from_state(state, index);
+    segment.t1 = whisper_full_get_segment_t1_from_state(state, index);
+
+    const whisper_token eot = whisper_token_eot(ctx); // Ids from here up are special tokens
+    QHash<whisper_token, int> counts;
+    double logprobSum = 0.0;
+    for (int i = 0; i < whisper_full_n_tokens_from_state(state, index); ++i) {
+        const whisper_token_data token = whisper_full_get_token_data_from_state(state, index, i);
+        if (token.id >= eot) continue;
+        logprobSum += token.plog;
+        ++counts[token.id];
+        ++segment.tokens;
+    }
+    if (segment.tokens == 0) return segment;
+    segment.logprob = logprobSum / segment.tokens;
+    for (int count : counts) {
+        const double p = double(count) / segment.tokens;
+        segment.entropy -= p * std::log(p);
+    }
+    return segment;
+}
+
+// Encoder time per job, from the callbacks whisper already offers: the
+// encoder starts at encoder_begin and is done by the first logits filter call
+struct EncoderClock {
+    QElapsedTimer timer;
+    qint64 beganNs = -1;
+    qint64 totalNs = 0;
+
+    void install(whisper_full_params &wparams)
+    {
+        if (!timer.isValid()) timer.start();
+        wparams.encoder_begin_callback = [](whisper_context *, whisper_state *, void *userData) {
+            auto *clock = static_cast<EncoderClock*>(userData);
+            clock->beganNs = clock->timer.nsecsElapsed();
+            return true;
+        };
+        wparams.encoder_begin_callback_user_data = this;
+        wparams.logits_filter_callback = [](whisper_context *, whisper_state *, const whisper_token_data *, int, float *, void *userData) {
+            auto *clock = static_cast<EncoderClock*>(userData);
+            if (clock->beganNs < 0) return;
+            clock->totalNs += clock->timer.nsecsElapsed() - clock->beganNs;
+            clock->beganNs = -1;
+        };
+        wparams.logits_filter_callback_user_data = this;
+    }
+};
+
+} // namespace
+
+int DecodingPolicy::audioContextFor(qint64 samples)
+{
+    const qint64 margin = qint64(kAudioCtxMarginMs) * 16 + samples / 10;
+    const qint64 positions = (samples + margin + kSamplesPerPosition - 1) / kSamplesPerPosition;
+    const int aligned = int((positions + kAudioCtxAlign - 1) / kAudioCtxAlign * kAudioCtxAlign);
+    return aligned >= kFullAudioCtx ? 0 : aligned;
+}
+
+DecodingPolicy DecodingPolicy::fromSettings()
+{
+    DatabaseManager &db = DatabaseManager::instance();
+    DecodingPolicy policy; // "balanced"
+    const QString preset = db.getSetting("decode_preset", "balanced");
+    if (preset == "fast") {
+        policy.maxFallbacks = 1;
+        policy.budgetMs = 1000;
+    } else if (preset == "accurate") {
+        policy.strategy = BeamSearch;
+        policy.bestOf = 5;
+        policy.maxFallbacks = 5;
+        policy.budgetMs = 0;
+    }
+
+    // Individual settings override the preset
+    auto number = [&db](const char *key, double fallback) {
+        bool ok = false;
+        const double value = db.getSetting(key).toDouble(&ok);
+        return ok ? value : fallback;
+    };
+    const QString strategy = db.getSetting("decode_strategy");
+    if (strategy == "greedy") policy.strategy = Greedy;
+    else if (strategy == "beam") policy.strategy = BeamSearch;
+    policy.beamSize = qMax(1, int(number("decode_beam_size", policy.beamSize)));
+    policy.bestOf = qMax(1, int(number("decode_best_of", policy.bestOf)));
+    policy.maxFallbacks = qMax(0, int(number("decode_fallbacks", policy.maxFallbacks)));
+    policy.entropyThreshold = float(number("decode_entropy_threshold", policy.entropyThreshold));
+    policy.logprobThreshold = float(number("decode_logprob_threshold", policy.logprobThreshold));
+    policy.budgetMs = qMax(0, int(number("decode_budget_ms", policy.budgetMs)));
+    policy.dynamicAudioCtx = db.getSetting("dynamic_audio_ctx", "0") == "1";
+    return policy;
+}
+
+QString DecodingPolicy::describe() const
+{
+    return QString("%1, %2 fallbacks (entropy < %3 or logprob < %4), budget %5%6")
+        .arg(strategy == BeamSearch ? QString("beam %1").arg(beamSize) : QString("greedy"))
+        .arg(maxFallbacks)
+        .arg(entropyThreshold)
+        .arg(logprobThreshold)
+        .arg(budgetMs > 0 ? QString("%1 ms").arg(budgetMs) : QString("unlimited"))
+        .arg(dynamicAudioCtx ? ", encoder sized to short clips" : "");
+}
+
+void DecodingPolicy::apply(whisper_full_params &wparams) const
+{
+    wparams.strategy = strategy == BeamSearch ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+    wparams.beam_search.beam_size = beamSize;
+    wparams.beam_search.patience = -1.0f;
+    wparams.greedy.best_of = bestOf;
+    wparams.temperature = 0.0f;
+    wparams.temperature_inc = 0.0f; // Fallback happens in decode(), under the budget
+    wparams.entropy_thold = entropyThreshold;
+    wparams.logprob_thold = logprobThreshold;
+}
+
+whisper_full_params DecodingPolicy::baseParams(int threads)
+{
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.print_progress = false;
+    wparams.print_special = false;
+    wparams.print_realtime = false;
+    wparams.print_timestamps = false;
+    wparams.translate = false;
+    wparams.language = "en";
+    wparams.n_threads = qMax(1, threads);
+    wparams.offset_ms = 0;
+    return wparams;
+}
+
+whisper_full_params DecodingPolicy::params(int threads) const
+{
+    whisper_full_params wparams = baseParams(threads);
+    apply(wparams);
+    return wparams;
+}
+
+bool DecodingPolicy::decode(whisper_context *ctx, whisper_state *state, whisper_full_params wparams,
+                            const float *pcm, int samples, Result &result) const
+{
+    if (dynamicAudioCtx && samples <= kShortClipSamples) {
+        wparams.audio_ctx = audioContextFor(samples);
+        wparams.single_segment = true;
+        wparams.no_context = true;
+    }
+    result.audioCtx = wparams.audio_ctx;
+    EncoderClock clock;
+    clock.install(wparams);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (whisper_full_with_state(ctx, state, wparams, pcm, samples) != 0) return false;
+
+    QVector<Segment> segments;
+    for (int i = 0; i < whisper_full_n_segments_from_state(state); ++i) segments.append(readSegment(ctx, state, i));
+
+    auto passes = [this](const Segment &segment) {
+        if (segment.tokens == 0) return true; // Nothing a re-decode could improve
+        if (segment.logprob < logprobThreshold) return false;
+        return segment.tokens < kMinEntropyTokens || segment.entropy >= entropyThreshold;
+    };
+
+    // A re-decode still runs the encoder over a whole window, so it costs at
+    // least what one window of the first pass did
+    const int windows = qMax(1, (samples + kWindowSamples - 1) / kWindowSamples);
+    qint64 estimateMs = timer.elapsed() / windows;
+    std::vector<float> scratch;
+
+    for (Segment &segment : segments) {
+        // Retries are scored at their own temperature, which lowers their
+        // logprob, so like whisper's own fallback the first one that passes is
+        // taken. Only when none does is the most confident hypothesis kept.
+        Segment best = segment;
+        for (int attempt = 1; !passes(segment) && attempt <= maxFallbacks; ++attempt) {
+            if (budgetMs > 0 && timer.elapsed() + estimateMs > budgetMs) {
+                result.budgetHit = true;
+                break;
+            }
+            const qint64 from = qBound<qint64>(0, segment.t0 * kSamplesPerTick, samples);
+            const qint64 to = qBound<qint64>(from, segment.t1 * kSamplesPerTick, samples);
+            if (to <= from) break;
+            scratch.assign(pcm + from, pcm + to);
+            if (scratch.size() < size_t(kMinSamples)) scratch.resize(kMinSamples, 0.0f);
+
+            // Sampled at a higher temperature, one segment, no carried-over context
+            whisper_full_params retry = wparams;
+            retry.strategy = WHISPER_SAMPLING_GREEDY;
+            retry.temperature = qMin(1.0f, kTemperatureStep * attempt);
+            retry.single_segment = true;
+            retry.no_context = true;
+            if (dynamicAudioCtx) retry.audio_ctx = audioContextFor(qint64(scratch.size()));
+
+            QElapsedTimer retryTimer;
+            retryTimer.start();
+            const bool ok = whisper_full_with_state(ctx, state, retry, scratch.data(), int(scratch.size())) == 0;
+            estimateMs = retryTimer.elapsed();
+            ++result.fallbacks;
+            if (!ok) break; // Aborted: keep what we have
+            if (whisper_full_n_segments_from_state(state) < 1) continue;
+
+            Segment candidate = readSegment(ctx, state, 0);
+            if (candidate.tokens == 0) continue; // Empty is no improvement on a failing segment
+            candidate.t0 = segment.t0;
+            candidate.t1 = segment.t1;
+            if (passes(candidate)) {
+                segment = candidate; // Ends the loop
+            } else if (candidate.logprob > best.logprob) {
+                best = candidate;
+            }
+        }
+        if (!passes(segment)) {
+            segment = best;
+            ++result.unresolved;
+        }
+    }
+
+    for (const Segment &segment : segments) result.text += segment.text;
+    result.text = result.text.trimmed();
+    result.ms = timer.elapsed();
+    result.encodeMs = clock.totalNs / 1e6;
+    return true;
+}
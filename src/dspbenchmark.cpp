@@ -0,0 +1,243 @@
+#include "dspbenchmark.h"
+#include "audioconverter.h"
+#include "decoderbenchmark.h"
+#include "dspchain.h"
+#include "decodingpolicy.h"
+#include "inferenceworker.h"
+#include "modelfile.h"
+#include "wavfile.h"
+#include "whisperstatepool.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+struct ConversionCase {
+    const char *name;
+    AudioConverter::SampleFormat format;
+    int sampleRate;
+    int channels;
+};
+
+// Two tones plus a little noise, encoded in the device format
+QByteArray makeInput(const ConversionCase &c, int seconds)
+{
+    const int frames = c.sampleRate * seconds;
+    const int bytesPerSample = (c.format == AudioConverter::Int16) ? 2 : (c.format == AudioConverter::UInt8 ? 1 : 4);
+    QByteArray bytes(qsizetype(frames) * c.channels * bytesPerSample, Qt::Uninitialized);
+    uint32_t noise = 12345;
+
+    for (int i = 0; i < frames; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        const double t = double(i) / c.sampleRate;
+        const double value = 0.4 * std::sin(2.0 * M_PI * 440.0 * t)
+                           + 0.2 * std::sin(2.0 * M_PI * 3100.0 * t)
+                           + 0.01 * ((noise >> 8) / double(1 << 24) - 0.5);
+        for (int ch = 0; ch < c.channels; ++ch) {
+            const qsizetype index = qsizetype(i) * c.channels + ch;
+            switch (c.format) {
+            case AudioConverter::UInt8:
+                reinterpret_cast<uint8_t*>(bytes.data())[index] = uint8_t(128 + value * 127);
+                break;
+            case AudioConverter::Int16:
+                reinterpret_cast<int16_t*>(bytes.data())[index] = int16_t(value * 32767);
+                break;
+            case AudioConverter::Int32:
+                reinterpret_cast<int32_t*>(bytes.data())[index] = int32_t(value * 2147483647.0);
+                break;
+            case AudioConverter::Float:
+                reinterpret_cast<float*>(bytes.data())[index] = float(value);
+                break;
+            }
+        }
+    }
+    return bytes;
+}
+
+// Office-like test signal: voiced bursts over steady noise and a little hum
+QVector<float> makeNoisySpeech(int seconds)
+{
+    const int rate = AudioConverter::kTargetRate;
+    QVector<float> samples(rate * seconds);
+    uint32_t noise = 777;
+    for (int i = 0; i < samples.size(); ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        const double t = double(i) / rate;
+        const double envelope = std::fmod(t, 2.0) < 1.2 ? 0.05 : 0.0;
+        const double voiced = std::sin(2.0 * M_PI * 180.0 * t) + 0.6 * std::sin(2.0 * M_PI * 540.0 * t)
+                            + 0.3 * std::sin(2.0 * M_PI * 1260.0 * t);
+        samples[i] = float(envelope * voiced + 0.01 * std::sin(2.0 * M_PI * 50.0 * t)
+                           + 0.02 * ((noise >> 8) / double(1 << 24) - 0.5));
+    }
+    return samples;
+}
+
+QVector<float> runChain(DspChain &chain, const QVector<float> &input)
+{
+    QVector<float> output(input.size() + DspChain::kFrameSize);
+    int produced = 0;
+    for (int i = 0; i < input.size(); i += 1024) {
+        const int chunk = qMin(1024, int(input.size()) - i);
+        produced += chain.process(input.constData() + i, chunk, output.data() + produced);
+    }
+    produced += chain.flush(output.data() + produced);
+    output.resize(produced);
+    return output;
+}
+
+// One final job's decode; returns wall time in ms
+double decode(const WhisperStatePool &pool, whisper_state *state, const DecodingPolicy &policy,
+              const whisper_full_params &wparams, const QVector<float> &pcm, QString &text)
+{
+    QElapsedTimer timer;
+    timer.start();
+    DecodingPolicy::Result result;
+    text.clear();
+    if (policy.decode(pool.context(), state, wparams, pcm.constData(), int(pcm.size()), result)) text = result.text;
+    return timer.nsecsElapsed() / 1e6;
+}
+
+} // namespace
+
+int DspBenchmark::runConversion()
+{
+    const ConversionCase cases[] = {
+        {"48 kHz stereo Int16", AudioConverter::Int16, 48000, 2},
+        {"44.1 kHz stereo Int16", AudioConverter::Int16, 44100, 2},
+        {"48 kHz mono Int32", AudioConverter::Int32, 48000, 1},
+        {"44.1 kHz mono Float", AudioConverter::Float, 44100, 1},
+        {"16 kHz mono Int16", AudioConverter::Int16, 16000, 1},
+        {"16 kHz mono Float", AudioConverter::Float, 16000, 1},
+    };
+    const int seconds = 10;
+    const int repeats = 5;
+
+    QTextStream out(stdout);
+    out << "AudioConverter: device format -> 16 kHz mono float (" << seconds << " s of audio, best of "
+        << repeats << ")\n";
+
+    for (const ConversionCase &c : cases) {
+        const QByteArray input = makeInput(c, seconds);
+        AudioConverter converter;
+        converter.configure(c.format, c.sampleRate, c.channels);
+        QVector<float> output(converter.maxOutputSamples());
+        const int frameBytes = converter.bytesPerFrame();
+        const int totalFrames = c.sampleRate * seconds;
+
+        double best = -1.0;
+        for (int r = 0; r < repeats; ++r) {
+            converter.reset();
+            converter.resetStats();
+            for (int frame = 0; frame < totalFrames; frame += AudioConverter::kChunkFrames) {
+                const int chunk = qMin(int(AudioConverter::kChunkFrames), totalFrames - frame);
+                converter.process(input.constData() + qsizetype(frame) * frameBytes, chunk, output.data());
+            }
+            const double cost = converter.microsPerSecondOfAudio();
+            if (best < 0.0 || cost < best) best = cost;
+        }
+
+        out << QString("  %1  %2 us per second of audio  (%3% of one core)\n")
+                   .arg(QString(c.name), -24)
+                   .arg(best, 8, 'f', 1)
+                   .arg(best / 10000.0, 0, 'f', 3);
+    }
+    out.flush();
+    return 0;
+}
+
+int DspBenchmark::runDsp(const QString &corpusDir, const QString &modelPath)
+{
+    QTextStream out(stdout);
+
+    // 1. Cost per stage on a synthetic noisy signal
+    const int seconds = 30;
+    const int repeats = 5;
+    const QVector<float> signal = makeNoisySpeech(seconds);
+    struct Stage { const char *name; bool highPass, suppression, agc; };
+    const Stage stages[] = {
+        {"High-pass only", true, false, false},
+        {"Noise suppression only", false, true, false},
+        {"AGC only", false, false, true},
+        {"Full chain", true, true, true},
+    };
+
+    out << "DspChain: 16 kHz mono (" << seconds << " s of audio, best of " << repeats << ")\n";
+    for (const Stage &stage : stages) {
+        DspChain chain;
+        chain.setStages(stage.highPass, stage.suppression, stage.agc);
+        double best = -1.0;
+        for (int r = 0; r < repeats; ++r) {
+            chain.reset();
+            chain.resetStats();
+            runChain(chain, signal);
+            const double cost = chain.microsPerSecondOfAudio();
+            if (best < 0.0 || cost < best) best = cost;
+        }
+        out << QString("  %1  %2 us per second of audio  (%3% of one core)\n")
+                   .arg(QString(stage.name), -24)
+                   .arg(best, 8, 'f', 1)
+                   .arg(best / 10000.0, 0, 'f', 3);
+    }
+    out.flush();
+
+    if (corpusDir.isEmpty()) return 0;
+
+    // 2. Decode time over a corpus, raw vs. cleaned up
+    const QString model = DecoderBenchmark::resolveModel(modelPath);
+    const QStringList files = QDir(corpusDir).entryList({"*.wav"}, QDir::Files, QDir::Name);
+    if (files.isEmpty()) {
+        out << "No .wav files in " << corpusDir << "\n";
+        return 1;
+    }
+
+    ModelFile file;
+    const std::shared_ptr<WhisperStatePool> pool = file.open(model, true) ? WhisperStatePool::load(file, 1) : nullptr;
+    if (!pool) {
+        out << "Could not load model " << model << "\n";
+        return 1;
+    }
+    WhisperStatePool::Lease lease = pool->acquire();
+    const DecodingPolicy policy = DecoderBenchmark::openSettings() ? DecodingPolicy::fromSettings() : DecodingPolicy();
+    const whisper_full_params wparams = policy.params(InferenceWorker::configuredThreads());
+
+    out << "\nDecode time with and without the chain (" << QFileInfo(model).fileName() << ", " << wparams.n_threads
+        << " threads, " << policy.describe() << ")\n";
+    double totalRaw = 0.0, totalDsp = 0.0, totalAudio = 0.0;
+    for (const QString &name : files) {
+        QVector<float> raw;
+        if (!WavFile::load(QDir(corpusDir).filePath(name), raw) || raw.isEmpty()) {
+            out << "  " << name << ": unsupported WAV, skipped\n";
+            continue;
+        }
+        DspChain chain;
+        const QVector<float> cleaned = runChain(chain, raw);
+
+        QString rawText, dspText;
+        const double rawMs = decode(*pool, lease.state(), policy, wparams, raw, rawText);
+        const double dspMs = decode(*pool, lease.state(), policy, wparams, cleaned, dspText);
+        const double audioSeconds = raw.size() / double(AudioConverter::kTargetRate);
+        totalRaw += rawMs;
+        totalDsp += dspMs;
+        totalAudio += audioSeconds;
+
+        out << QString("  %1  %2 s audio  raw %3 ms  dsp %4 ms  (%5%)\n")
+                   .arg(name, -28)
+                   .arg(audioSeconds, 6, 'f', 1)
+                   .arg(rawMs, 8, 'f', 0)
+                   .arg(dspMs, 8, 'f', 0)
+                   .arg(rawMs > 0 ? 100.0 * (dspMs - rawMs) / rawMs : 0.0, 6, 'f', 1);
+        out << "      raw: " << rawText.trimmed() << "\n";
+        out << "      dsp: " << dspText.trimmed() << "\n";
+        out.flush();
+    }
+
+    out << QString("  Total: %1 s of audio, raw %2 ms, dsp %3 ms\n")
+               .arg(totalAudio, 0, 'f', 1).arg(totalRaw, 0, 'f', 0).arg(totalDsp, 0, 'f', 0);
+    out.flush();
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include "dspchain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+static const float kHighPassHz = 80.0f;
+
+// Spectral subtraction
+static const float kOverSubtraction = 1.5f;
+static const float kGainFloor = 0.15f;        // ~-16 dB: keeps a little residual noise, avoids "musical" artefacts
+static const float kGainRelease = 0.6f;       // Per-frame smoothing when a bin's gain drops
+static const float kPowerSmoothing = 0.7f;    // Per-bin power is averaged over frames before tracking
+static const float kNoiseFall = 0.8f;         // Noise floor follows drops quickly...
+static const float kNoiseRise = 1.02f;        // ...and rises ~5 dB/s, too slow to learn speech as noise
+static const float kMinimumBias = 2.0f;       // A tracked minimum sits well below the mean noise power
+static const int kWarmupFrames = 16;          // ~0.25 s of fast tracking for the very first estimate
+static const float kInitialNoiseDb = -70.0f;
+
+// AGC
+static const int kAgcBlock = 160;             // 10 ms
+static const float kAgcTargetRms = 0.1f;      // -20 dBFS
+static const float kAgcGateRms = 0.00316f;    // -50 dBFS: hold the gain during pauses instead of boosting noise
+static const float kAgcMinGain = 0.5f;
+static const float kAgcMaxGain = 16.0f;       // +24 dB
+static const float kAgcRiseStep = 1.01158f;   // +10 dB/s at 10 ms blocks
+static const float kAgcAttack = 0.5f;
+static const float kAgcPeakLimit = 0.9f;
+
+DspChain::DspChain(int sampleRate) : m_sampleRate(sampleRate), m_fft(kFrameSize)
+{
+    // RBJ cookbook high-pass, Q = 1/sqrt(2) (Butterworth)
+    const double w0 = 2.0 * M_PI * kHighPassHz / sampleRate;
+    const double alpha = std::sin(w0) / (2.0 * M_SQRT1_2);
+    const double cosw0 = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    m_b0 = float((1.0 + cosw0) / 2.0 / a0);
+    m_b1 = float(-(1.0 + cosw0) / a0);
+    m_b2 = m_b0;
+    m_a1 = float(-2.0 * cosw0 / a0);
+    m_a2 = float((1.0 - alpha) / a0);
+
+    // Periodic sqrt-Hann: analysis * synthesis sums to 1 at 50% overlap
+    m_window.resize(kFrameSize);
+    for (int i = 0; i < kFrameSize; ++i) {
+        m_window[i] = float(std::sqrt(0.5 - 0.5 * std::cos(2.0 * M_PI * i / kFrameSize)));
+    }
+
+    m_frame.assign(kFrameSize, 0.0f);
+    m_overlap.assign(kFrameSize, 0.0f);
+    m_re.assign(kFrameSize, 0.0f);
+    m_im.assign(kFrameSize, 0.0f);
+    m_gain.assign(kFrameSize, 1.0f);
+
+    // |X(k)|^2 of white noise at the initial level, through the window
+    const float initialNoise = std::pow(10.0f, kInitialNoiseDb / 10.0f) * kFrameSize / 2;
+    m_noise.assign(kFrameSize / 2 + 1, initialNoise);
+    m_power.assign(kFrameSize / 2 + 1, initialNoise);
+
+    reset();
+}
+
+void DspChain::setStages(bool highPass, bool suppression, bool agc)
+{
+    m_highPass = highPass;
+    m_suppression = suppression;
+    m_agc = agc;
+    reset();
+}
+
+void DspChain::reset()
+{
+    m_z1 = m_z2 = 0.0f;
+
+    // Start with half a frame of silence so the first real hop gets the full
+    // window overlap; the matching half frame of output is discarded
+    std::fill(m_frame.begin(), m_frame.end(), 0.0f);
+    std::fill(m_overlap.begin(), m_overlap.end(), 0.0f);
+    m_frameFill = kHop;
+    m_skip = kHop;
+    m_owed = 0;
+}
+
+int DspChain::process(const float *in, int count, float *out)
+{
+    const auto started = std::chrono::steady_clock::now();
+    int produced = 0;
+
+    if (!m_suppression) {
+        std::memcpy(out, in, size_t(count) * sizeof(float));
+        if (m_highPass) highPass(out, count);
+        produced = count;
+    } else {
+        m_owed += count;
+        while (count > 0) {
+            const int take = std::min(count, kFrameSize - m_frameFill);
+            float *dest = m_frame.data() + m_frameFill;
+            std::memcpy(dest, in, size_t(take) * sizeof(float));
+            if (m_highPass) highPass(dest, take);
+            m_frameFill += take;
+            in += take;
+            count -= take;
+
+            if (m_frameFill == kFrameSize) {
+                suppressFrame();
+                produced += emitHop(out + produced);
+            }
+        }
+    }
+
+    if (m_agc) autoGain(out, produced);
+
+    m_costNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    m_samplesIn += produced;
+    return produced;
+}
+
+int DspChain::flush(float *out)
+{
+    int produced = 0;
+    // Push silence through until every real input sample has come out
+    while (m_suppression && m_owed > 0) {
+        std::fill(m_frame.begin() + m_frameFill, m_frame.end(), 0.0f);
+        m_frameFill = kFrameSize;
+        suppressFrame();
+        produced += emitHop(out + produced);
+    }
+    if (m_agc) autoGain(out, produced);
+    return produced;
+}
+
+void DspChain::highPass(float *samples, int count)
+{
+    // Recursive, so inherently serial; a handful of flops per sample
+    float z1 = m_z1, z2 = m_z2;
+    for (int i = 0; i < count; ++i) {
+        const float x = samples[i];
+        const float y = m_b0 * x + z1;
+        z1 = m_b1 * x - m_a1 * y + z2;
+        z2 = m_b2 * x - m_a2 * y;
+        samples[i] = y;
+    }
+    m_z1 = z1;
+    m_z2 = z2;
+}
+
+void DspChain::suppressFrame()
+{
+    const int bins = kFrameSize / 2 + 1;
+    const float noiseFall = (m_framesSeen < kWarmupFrames) ? 0.5f : kNoiseFall;
+    const float noiseRise = (m_framesSeen < kWarmupFrames) ? 2.0f : kNoiseRise;
+    ++m_framesSeen;
+
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= kFrameSize; i += 8) {
+        _mm256_storeu_ps(&m_re[i], _mm256_mul_ps(_mm256_loadu_ps(&m_frame[i]), _mm256_loadu_ps(&m_window[i])));
+        _mm256_storeu_ps(&m_im[i], _mm256_setzero_ps());
+    }
+#endif
+    for (; i < kFrameSize; ++i) {
+        m_re[i] = m_frame[i] * m_window[i];
+        m_im[i] = 0.0f;
+    }
+    m_fft.forward(m_re.data(), m_im.data());
+
+    // Per-bin noise tracking and gain for 0..N/2
+    int k = 0;
+#if defined(__AVX__)
+    const __m256 fall = _mm256_set1_ps(noiseFall);
+    const __m256 fallRest = _mm256_set1_ps(1.0f - noiseFall);
+    const __m256 rise = _mm256_set1_ps(noiseRise);
+    const __m256 over = _mm256_set1_ps(kOverSubtraction * kMinimumBias);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 floor = _mm256_set1_ps(kGainFloor);
+    const __m256 release = _mm256_set1_ps(kGainRelease);
+    const __m256 releaseRest = _mm256_set1_ps(1.0f - kGainRelease);
+    const __m256 eps = _mm256_set1_ps(1e-12f);
+    const __m256 smoothing = _mm256_set1_ps(kPowerSmoothing);
+    const __m256 smoothingRest = _mm256_set1_ps(1.0f - kPowerSmoothing);
+    for (; k + 8 <= bins; k += 8) {
+        const __m256 re = _mm256_loadu_ps(&m_re[k]);
+        const __m256 im = _mm256_loadu_ps(&m_im[k]);
+        const __m256 power = _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im));
+        const __m256 smoothed = _mm256_add_ps(_mm256_mul_ps(smoothing, _mm256_loadu_ps(&m_power[k])),
+                                              _mm256_mul_ps(smoothingRest, power));
+        _mm256_storeu_ps(&m_power[k], smoothed);
+
+        __m256 noise = _mm256_loadu_ps(&m_noise[k]);
+        const __m256 lower = _mm256_cmp_ps(smoothed, noise, _CMP_LT_OQ);
+        const __m256 fallen = _mm256_add_ps(_mm256_mul_ps(fall, noise), _mm256_mul_ps(fallRest, smoothed));
+        const __m256 risen = _mm256_min_ps(smoothed, _mm256_mul_ps(noise, rise));
+        noise = _mm256_blendv_ps(risen, fallen, lower);
+        _mm256_storeu_ps(&m_noise[k], noise);
+
+        const __m256 ratio = _mm256_div_ps(_mm256_mul_ps(over, noise), _mm256_add_ps(power, eps));
+        const __m256 gain = _mm256_max_ps(floor, _mm256_sub_ps(one, ratio));
+        const __m256 previous = _mm256_loadu_ps(&m_gain[k]);
+        const __m256 released = _mm256_add_ps(_mm256_mul_ps(release, previous), _mm256_mul_ps(releaseRest, gain));
+        _mm256_storeu_ps(&m_gain[k], _mm256_max_ps(gain, released)); // Rise at once, fall smoothly
+    }
+#endif
+    for (; k < bins; ++k) {
+        const float power = m_re[k] * m_re[k] + m_im[k] * m_im[k];
+        const float smoothed = m_power[k] = kPowerSmoothing * m_power[k] + (1.0f - kPowerSmoothing) * power;
+        float &noise = m_noise[k];
+        noise = (smoothed < noise) ? noiseFall * noise + (1.0f - noiseFall) * smoothed
+                                   : std::min(smoothed, noise * noiseRise);
+        const float gain = std::max(kGainFloor, 1.0f - kOverSubtraction * kMinimumBias * noise / (power + 1e-12f));
+        const float released = kGainRelease * m_gain[k] + (1.0f - kGainRelease) * gain;
+        m_gain[k] = std::max(gain, released);
+    }
+
+    // Real input: bins above N/2 mirror the lower half
+    for (k = 1; k < kFrameSize / 2; ++k) m_gain[kFrameSize - k] = m_gain[k];
+
+    i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= kFrameSize; i += 8) {
+        const __m256 gain = _mm256_loadu_ps(&m_gain[i]);
+        _mm256_storeu_ps(&m_re[i], _mm256_mul_ps(_mm256_loadu_ps(&m_re[i]), gain));
+        _mm256_storeu_ps(&m_im[i], _mm256_mul_ps(_mm256_loadu_ps(&m_im[i]), gain));
+    }
+#endif
+    for (; i < kFrameSize; ++i) {
+        m_re[i] *= m_gain[i];
+        m_im[i] *= m_gain[i];
+    }
+
+    m_fft.inverse(m_re.data(), m_im.data());
+
+    i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= kFrameSize; i += 8) {
+        const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(&m_re[i]), _mm256_loadu_ps(&m_window[i]));
+        _mm256_storeu_ps(&m_overlap[i], _mm256_add_ps(_mm256_loadu_ps(&m_overlap[i]), y));
+    }
+#endif
+    for (; i < kFrameSize; ++i) m_overlap[i] += m_re[i] * m_window[i];
+}
+
+// The first hop of the accumulator is complete: hand it out and slide both buffers
+int DspChain::emitHop(float *out)
+{
+    int produced = 0;
+    const int skip = int(std::min<int64_t>(m_skip, kHop));
+    const int count = int(std::min<int64_t>(kHop - skip, m_owed));
+    if (count > 0) {
+        std::memcpy(out, m_overlap.data() + skip, size_t(count) * sizeof(float));
+        produced = count;
+        m_owed -= count;
+    }
+    m_skip -= skip;
+
+    std::memmove(m_overlap.data(), m_overlap.data() + kHop, kHop * sizeof(float));
+    std::fill(m_overlap.begin() + kHop, m_overlap.end(), 0.0f);
+    std::memmove(m_frame.data(), m_frame.data() + kHop, kHop * sizeof(float));
+    m_frameFill = kHop;
+    return produced;
+}
+
+void DspChain::autoGain(float *samples, int count)
+{
+    for (int start = 0; start < count; start += kAgcBlock) {
+        float *block = samples + start;
+        const int n = std::min(kAgcBlock, count - start);
+
+        float sumSquares = 0.0f, peak = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            sumSquares += block[i] * block[i];
+            peak = std::max(peak, std::abs(block[i]));
+        }
+        const float rms = std::sqrt(sumSquares / n);
+
+        float target = m_agcGain;
+        if (rms > kAgcGateRms) {
+            const float desired = std::clamp(kAgcTargetRms / rms, kAgcMinGain, kAgcMaxGain);
+            target = (desired < m_agcGain) ? m_agcGain + (desired - m_agcGain) * kAgcAttack
+                                           : std::min(desired, m_agcGain * kAgcRiseStep);
+        }
+        if (peak * target > kAgcPeakLimit) target = kAgcPeakLimit / peak;
+
+        // Linear ramp to the new gain across the block, so there are no steps
+        const float step = (target - m_agcGain) / n;
+        float gain = m_agcGain;
+        for (int i = 0; i < n; ++i) {
+            gain += step;
+            block[i] = std::clamp(block[i] * gain, -1.0f, 1.0f);
+        }
+        m_agcGain = target;
+    }
+}
+
+double DspChain::microsPerSecondOfAudio() const
+{
+    if (m_samplesIn == 0) return 0.0;
+    return (m_costNanos / 1000.0) / (double(m_samplesIn) / m_sampleRate);
+}
+
+void DspChain::resetStats()
+{
+    m_costNanos = 0;
+    m_samplesIn = 0;
+}
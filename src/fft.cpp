@@ -0,0 +1,118 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+Fft::Fft(int size) : m_size(size)
+{
+    int bits = 0;
+    while ((1 << bits) < size) ++bits;
+
+    for (int i = 0; i < size; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        if (reversed > i) {
+            m_swaps.push_back(i);
+            m_swaps.push_back(reversed);
+        }
+    }
+
+    // Stage with half-size h uses twiddles exp(-2*pi*i*k / 2h), k < h, stored at offset h - 1
+    m_twiddleRe.resize(size > 1 ? size - 1 : 1);
+    m_twiddleIm.resize(size > 1 ? size - 1 : 1);
+    for (int half = 1; half < size; half <<= 1) {
+        for (int k = 0; k < half; ++k) {
+            const double angle = -M_PI * k / half;
+            m_twiddleRe[half - 1 + k] = float(std::cos(angle));
+            m_twiddleIm[half - 1 + k] = float(std::sin(angle));
+        }
+    }
+}
+
+void Fft::forward(float *re, float *im) const
+{
+    bitReverse(re, im);
+    butterflies(re, im);
+}
+
+void Fft::inverse(float *re, float *im) const
+{
+    // ifft(x) == swap(fft(swap(x))) / N, so reuse the forward kernels
+    forward(im, re);
+    const float scale = 1.0f / m_size;
+    for (int i = 0; i < m_size; ++i) {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+void Fft::bitReverse(float *re, float *im) const
+{
+    for (size_t i = 0; i < m_swaps.size(); i += 2) {
+        std::swap(re[m_swaps[i]], re[m_swaps[i + 1]]);
+        std::swap(im[m_swaps[i]], im[m_swaps[i + 1]]);
+    }
+}
+
+void Fft::butterflies(float *re, float *im) const
+{
+    for (int half = 1; half < m_size; half <<= 1) {
+        const float *wRe = m_twiddleRe.data() + half - 1;
+        const float *wIm = m_twiddleIm.data() + half - 1;
+
+        for (int group = 0; group < m_size; group += 2 * half) {
+            float *aRe = re + group;
+            float *aIm = im + group;
+            float *bRe = aRe + half;
+            float *bIm = aIm + half;
+            int k = 0;
+
+#if defined(__AVX__)
+            for (; k + 8 <= half; k += 8) {
+                __m256 wr = _mm256_loadu_ps(wRe + k);
+                __m256 wi = _mm256_loadu_ps(wIm + k);
+                __m256 br = _mm256_loadu_ps(bRe + k);
+                __m256 bi = _mm256_loadu_ps(bIm + k);
+                __m256 tr = _mm256_sub_ps(_mm256_mul_ps(wr, br), _mm256_mul_ps(wi, bi));
+                __m256 ti = _mm256_add_ps(_mm256_mul_ps(wr, bi), _mm256_mul_ps(wi, br));
+                __m256 ar = _mm256_loadu_ps(aRe + k);
+                __m256 ai = _mm256_loadu_ps(aIm + k);
+                _mm256_storeu_ps(bRe + k, _mm256_sub_ps(ar, tr));
+                _mm256_storeu_ps(bIm + k, _mm256_sub_ps(ai, ti));
+                _mm256_storeu_ps(aRe + k, _mm256_add_ps(ar, tr));
+                _mm256_storeu_ps(aIm + k, _mm256_add_ps(ai, ti));
+            }
+#endif
+#if defined(__SSE__)
+            for (; k + 4 <= half; k += 4) {
+                __m128 wr = _mm_loadu_ps(wRe + k);
+                __m128 wi = _mm_loadu_ps(wIm + k);
+                __m128 br = _mm_loadu_ps(bRe + k);
+                __m128 bi = _mm_loadu_ps(bIm + k);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+                __m128 ar = _mm_loadu_ps(aRe + k);
+                __m128 ai = _mm_loadu_ps(aIm + k);
+                _mm_storeu_ps(bRe + k, _mm_sub_ps(ar, tr));
+                _mm_storeu_ps(bIm + k, _mm_sub_ps(ai, ti));
+                _mm_storeu_ps(aRe + k, _mm_add_ps(ar, tr));
+                _mm_storeu_ps(aIm + k, _mm_add_ps(ai, ti));
+            }
+#endif
+            // Scalar tail (and the whole stage for small half-sizes)
+            for (; k < half; ++k) {
+                const float tr = wRe[k] * bRe[k] - wIm[k] * bIm[k];
+                const float ti = wRe[k] * bIm[k] + wIm[k] * bRe[k];
+                bRe[k] = aRe[k] - tr;
+                bIm[k] = aIm[k] - ti;
+                aRe[k] += tr;
+                aIm[k] += ti;
+            }
+        }
+    }
+}
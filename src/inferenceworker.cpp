@@ -1,131 +1,834 @@
 #include "inferenceworker.h"
 #include "databasemanager.h"
+#include "modelfile.h"
+#include "whisperstatepool.h"
+#include "threadcalibrator.h"
+#include "cputopology.h"
+#include "longformtranscriber.h"
+#include "modelcatalog.h"
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Streaming budget. A partial should show up within kPartialTargetMs of the
+// audio it covers; the worst case is one wait step plus one decode, so the
+// step shrinks as decodes get faster and backs off when they can't keep up.
+static const int kPartialTargetMs = 500;
+static const int kFirstPartialMs = 300;
+static const int kMinStepMs = 100;
+static const int kMaxStepMs = 2000;
+static const int kMinWindowMs = 1000;    // whisper skips shorter input; pad up to this
+static const int kCommitWindowMs = 6000; // Past this, all but the last segment are committed
+static const int kMaxWindowMs = 12000;   // Hard cap: commit everything
+static const int kPromptChars = 200;     // Earlier text of the take, passed as the next decode's prompt
+static const int kSelfTestMs = 2000;     // Audio decoded by a new model before it goes live
+static const int kSelfTestTimeoutMs = 30000;
+static const int kWarmupPasses = 2;      // The first still pays for cold paths; the second shows steady state
+static const int kResidencyCheckMs = 15000;
+static const qint64 kMinIdleForPressureMs = 60000; // Pressure alone never evicts between two dictations
+
+// Quiet noise rather than digital silence, so the encoder sees real input
+static QVector<float> quietNoise(int samples)
+{
+    QVector<float> pcm(samples);
+    quint32 seed = 1;
+    for (float &sample : pcm) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = (float(seed >> 8) / float(1 << 24) - 0.5f) * 0.002f;
+    }
+    return pcm;
+}
+
+static int percentile(QVector<qint64> values, double p)
+{
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    return int(values[qMin(values.size() - 1, int(p * values.size()))]);
+}
 
 InferenceWorker::InferenceWorker(QObject *parent) : QThread(parent)
 {
-    struct whisper_context_params cparams = whisper_context_default_params();
+    // No model yet: loadModel() reads it on a background thread
+    reloadSettings();
+
+    // Emitted on the loader thread, saved here on the GUI thread that owns the database
+    connect(this, &InferenceWorker::threadsCalibrated, this, [](int threads, QString cpu, QString modelPath) {
+        DatabaseManager::instance().setSetting("calibrated_threads", QString::number(threads));
+        DatabaseManager::instance().setSetting("calibration_cpu", cpu);
+        DatabaseManager::instance().setSetting("calibration_model", modelPath);
+    });
+
+    // Budget hit rate, accumulated across sessions
+    const quint64 jobsBefore = DatabaseManager::instance().getSetting("decode_budget_jobs", "0").toULongLong();
+    const quint64 hitsBefore = DatabaseManager::instance().getSetting("decode_budget_hits", "0").toULongLong();
+    connect(this, &InferenceWorker::decodeBudgetStats, this, [=](quint64 jobs, quint64 budgetHits) {
+        DatabaseManager::instance().setSetting("decode_budget_jobs", QString::number(jobsBefore + jobs));
+        DatabaseManager::instance().setSetting("decode_budget_hits", QString::number(hitsBefore + budgetHits));
+    });
+
+    m_idleSince.start();
+    m_residencyTimer = new QTimer(this);
+    m_residencyTimer->setInterval(kResidencyCheckMs);
+    connect(m_residencyTimer, &QTimer::timeout, this, &InferenceWorker::checkResidency);
+    m_residencyTimer->start();
+}
+
+InferenceWorker::~InferenceWorker()
+{
+    stop();
+    wait();
+    {
+        QMutexLocker locker(&mutex);
+        m_hasNextLoad = false;
+    }
+    if (m_loader) {
+        m_loader->wait(); // m_stop makes its reads fail, so this is quick
+        delete m_loader;
+    }
+}
+
+QString InferenceWorker::configuredModelPath()
+{
     QString modelPath = DatabaseManager::instance().getSetting("model_path");
-    
+
     // Fallback logic for development or manual folder placement
     if (modelPath.isEmpty() || !QFile::exists(modelPath)) {
         modelPath = QCoreApplication::applicationDirPath() + "/models/ggml-base.en.bin";
     }
-    
-    qDebug() << "Loading model from:" << modelPath;
-    ctx = whisper_init_from_file_with_params(modelPath.toStdString().c_str(), cparams);
-    
-    if (!ctx) {
-        qCritical() << "Failed to initialize whisper context";
-    } else {
-        qDebug() << "Whisper initialized successfully";
-    }
+    return modelPath;
 }
 
-InferenceWorker::~InferenceWorker()
+// inference_threads overrides; otherwise the calibrated count, if it was
+// measured on this CPU; otherwise the old conservative default
+int InferenceWorker::configuredThreads(QString *source)
 {
-    stop();
-    wait();
-    if (ctx) whisper_free(ctx);
+    const int overrideThreads = DatabaseManager::instance().getSetting("inference_threads", "0").toInt();
+    const bool sameCpu = DatabaseManager::instance().getSetting("calibration_cpu") == ThreadCalibrator::cpuModel();
+    const int calibrated = sameCpu ? DatabaseManager::instance().getSetting("calibrated_threads", "0").toInt() : 0;
+
+    if (source) *source = overrideThreads > 0 ? "override" : calibrated > 0 ? "calibrated" : "default";
+    if (overrideThreads > 0) return overrideThreads;
+    if (calibrated > 0) return calibrated;
+    return qMin(4, CpuTopology::instance().computeCpuCount());
 }
 
-void InferenceWorker::addAudio(const QVector<float> &audio)
+void InferenceWorker::reloadSettings()
 {
-    // We still keep this to avoid breaking existing signatures, 
-    // but focus on requestFinalTranscription for actual processing.
+    QString source;
+    m_threadOverride = DatabaseManager::instance().getSetting("inference_threads", "0").toInt();
+    m_threads = configuredThreads(&source);
+    qDebug() << "Inference threads:" << m_threads.load() << "(" + source + ")";
+
+    const DecodingPolicy policy = DecodingPolicy::fromSettings();
+    qDebug() << "Decoding:" << policy.describe();
+
+    m_idleEvictMs = qMax<qint64>(0, DatabaseManager::instance().getSetting("model_idle_minutes", "30").toLongLong()) * 60000;
+    m_evictPressure = qMax(0.0, DatabaseManager::instance().getSetting("model_evict_pressure", "10").toDouble());
+    QMutexLocker locker(&mutex);
+    m_policy = policy;
 }
 
 void InferenceWorker::clear()
 {
     QMutexLocker locker(&mutex);
-    m_shouldClear = true;
-    m_hasFinalRequest = false;
-    m_finalProcessingBuffer.clear();
+    m_jobs.clear();
+    m_chunksReset = true; // A new take: forget chunk text from an unfinished one
+}
+
+void InferenceWorker::startStreaming(const AudioSource &source)
+{
+    QMutexLocker locker(&mutex);
+    m_streamSource = source;
+    m_idleSince.start();
+    m_streamRestart = true;
+    m_partialLatencies.clear();
+    m_nextPartial = QDeadlineTimer(kFirstPartialMs);
+    m_wake.wakeOne();
+}
+
+void InferenceWorker::stopStreaming()
+{
+    QMutexLocker locker(&mutex);
+    if (!m_streamSource) return;
+    m_streamSource = nullptr;
+    m_nextPartial = QDeadlineTimer(QDeadlineTimer::Forever);
+    m_abortPartial = true; // The final pass shouldn't queue behind a stale partial
+
+    if (!m_partialLatencies.isEmpty()) {
+        const int over = int(std::count_if(m_partialLatencies.begin(), m_partialLatencies.end(),
+                                           [](qint64 ms) { return ms > kPartialTargetMs; }));
+        qDebug() << "Streaming:" << m_partialLatencies.size() << "partials, audio-to-text p50"
+                 << percentile(m_partialLatencies, 0.5) << "ms, p95" << percentile(m_partialLatencies, 0.95)
+                 << "ms," << over << "over the" << kPartialTargetMs << "ms target";
+    }
 }
 
 void InferenceWorker::stop()
 {
     m_stop = true;
+    QMutexLocker locker(&mutex);
+    m_wake.wakeAll();
+}
+
+void InferenceWorker::requestFinalTranscription(const RecordingView &audio)
+{
+    wakeModel(); // First, so the job waits for the reload instead of finding no model
+    enqueue({Job::Final, audio}); // Shares the recorder's storage, no sample copy
+}
+
+void InferenceWorker::addChunk(const RecordingView &chunk, bool overlapped)
+{
+    enqueue({Job::Chunk, chunk, overlapped});
+}
+
+void InferenceWorker::finishChunks()
+{
+    enqueue({Job::FinishChunks});
 }
 
-void InferenceWorker::requestFinalTranscription(const QVector<float> &audio)
+void InferenceWorker::enqueue(const Job &job)
 {
     QMutexLocker locker(&mutex);
-    m_finalProcessingBuffer = audio;
-    m_hasFinalRequest = true;
+    m_idleSince.start();
+    m_jobs.enqueue(job);
+    m_abortPartial = true;
+    m_wake.wakeOne();
 }
 
-void InferenceWorker::reloadModel(const QString &modelPath)
+void InferenceWorker::loadModel(const QString &modelPath)
+{
+    queueLoad(modelPath, configuredLoadOptions(modelPath));
+}
+
+InferenceWorker::LoadOptions InferenceWorker::configuredLoadOptions(const QString &modelPath) const
+{
+    LoadOptions options;
+    options.mapped = DatabaseManager::instance().getSetting("model_mmap", "1") == "1";
+    options.prefault = DatabaseManager::instance().getSetting("model_prefault", "1") == "1";
+    options.states = DatabaseManager::instance().getSetting("whisper_states", "2").toInt();
+    options.warmup = DatabaseManager::instance().getSetting("model_warmup", "1") == "1";
+    // First run, a different model, or a different CPU: measure again (unless overridden)
+    options.calibrate = m_threadOverride == 0
+        && (DatabaseManager::instance().getSetting("calibrated_threads", "0").toInt() <= 0
+            || DatabaseManager::instance().getSetting("calibration_cpu") != ThreadCalibrator::cpuModel()
+            || DatabaseManager::instance().getSetting("calibration_model") != modelPath);
+    return options;
+}
+
+void InferenceWorker::queueLoad(const QString &modelPath, const LoadOptions &options)
 {
     QMutexLocker locker(&mutex);
-    qDebug() << "Reloading model from:" << modelPath;
-    
-    if (ctx) {
-        whisper_free(ctx);
-        ctx = nullptr;
+    m_nextLoadOptions = options;
+    m_nextModelPath = modelPath;
+    m_hasNextLoad = true;
+    if (!m_loader) startLoader();
+}
+
+QString InferenceWorker::residencyName(Residency residency)
+{
+    switch (residency) {
+    case Loading: return "loading";
+    case Resident: return "resident";
+    case Evicted: return "evicted";
+    default: return "unloaded";
     }
-    
-    if (modelPath.isEmpty() || !QFile::exists(modelPath)) {
+}
+
+// Receivers get the state as an argument, so this may be called with mutex held
+void InferenceWorker::setResidency(Residency residency)
+{
+    if (m_residency.exchange(residency) != residency) emit residencyChanged(residencyName(residency));
+}
+
+void InferenceWorker::wakeModel()
+{
+    QString path;
+    {
+        QMutexLocker locker(&mutex);
+        if (m_evictedPath.isEmpty() || m_model || m_loading) return; // Not evicted, or already on its way back
+        path = m_evictedPath;
+    }
+    qDebug() << "Reloading evicted model" << path;
+    LoadOptions options = configuredLoadOptions(path);
+    options.selfTest = false; // Passed when it first loaded; the warmup still runs
+    options.calibrate = false;
+    queueLoad(path, options);
+}
+
+// PSI: "some avg10=1.23 avg60=... avg300=... total=...", the share of the
+// last 10 s in which at least one task stalled on memory
+double InferenceWorker::memoryPressure()
+{
+    QFile file("/proc/pressure/memory");
+    if (!file.open(QIODevice::ReadOnly)) return -1.0; // No PSI in this kernel or sandbox
+    const QByteArray some = file.readLine();
+    const int at = some.indexOf("avg10=");
+    if (!some.startsWith("some") || at < 0) return -1.0;
+    bool ok = false;
+    const double value = some.mid(at + 6, some.indexOf(' ', at) - at - 6).toDouble(&ok);
+    return ok ? value : -1.0;
+}
+
+// GUI thread: release an idle model. Jobs and streams hold their own
+// reference, so the context is only freed here when nothing is using it.
+void InferenceWorker::checkResidency()
+{
+    const double pressure = m_evictPressure > 0 ? memoryPressure() : -1.0;
+    Model evicted;
+    QString reason;
+    qint64 idleMs = 0;
+    {
+        QMutexLocker locker(&mutex);
+        if (!m_model || m_loading || !m_jobs.isEmpty() || m_streamSource || m_model.use_count() > 1) return;
+        idleMs = m_idleSince.elapsed();
+        if (m_idleEvictMs > 0 && idleMs >= m_idleEvictMs) {
+            reason = "idle";
+        } else if (m_evictPressure > 0 && pressure >= m_evictPressure && idleMs >= kMinIdleForPressureMs) {
+            reason = QString("memory pressure %1%").arg(pressure);
+        } else {
+            return;
+        }
+        evicted = std::move(m_model);
+        m_evictedPath = m_servingPath;
+        setResidency(Evicted);
+    }
+
+    const qint64 rssBeforeKb = ModelFile::residentKb();
+    evicted.reset(); // Frees the context and its states
+#ifdef __GLIBC__
+    malloc_trim(0); // Hand freed heap back to the system rather than keep it for reuse
+#endif
+    qDebug() << "Model evicted (" + reason + ") after" << idleMs / 1000 << "s idle, RSS" << rssBeforeKb / 1024 << "->"
+             << ModelFile::residentKb() / 1024 << "MB";
+}
+
+// GUI thread, mutex held: one load at a time; a request made meanwhile runs next
+void InferenceWorker::startLoader()
+{
+    const QString modelPath = m_nextModelPath;
+    const LoadOptions options = m_nextLoadOptions;
+    m_hasNextLoad = false;
+    m_loading = true;
+    if (!m_model) setResidency(Loading);
+    m_loader = QThread::create([=]() {
+        // Self-test and calibration should run where decodes will
+        CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+        loadInBackground(modelPath, options);
+    });
+    m_loader->setObjectName("ModelLoader");
+    connect(m_loader, &QThread::finished, this, [this]() {
+        QMutexLocker locker(&mutex);
+        m_loader->deleteLater();
+        m_loader = nullptr;
+        if (m_hasNextLoad) {
+            startLoader();
+        } else {
+            m_loading = false;
+            if (!m_model) setResidency(m_evictedPath.isEmpty() ? Unloaded : Evicted);
+            m_wake.wakeAll(); // Jobs held back for a first model run now, with or without one
+        }
+    });
+    m_loader->start(QThread::LowPriority);
+}
+
+// Loader thread: build the replacement next to the serving model, test it,
+// then publish it. Any failure leaves the current model in place.
+void InferenceWorker::loadInBackground(const QString &modelPath, const LoadOptions &options)
+{
+    qDebug() << "Loading model from:" << modelPath << (options.mapped ? "(mapped)" : "(read)");
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 rssBeforeKb = ModelFile::residentKb();
+    emit modelLoadProgress(0);
+
+    ModelFile file;
+    if (!file.open(modelPath, options.mapped)) {
         qCritical() << "Model file not found:" << modelPath;
+        emit modelFailed(modelPath, "Model file not found");
         return;
     }
-
-    struct whisper_context_params cparams = whisper_context_default_params();
-    ctx = whisper_init_from_file_with_params(modelPath.toStdString().c_str(), cparams);
-    
-    if (!ctx) {
+    const bool isMapped = file.isMapped(); // The loader closes the file when it's done
+    if (options.prefault) file.prefault();
+    file.setCancel(&m_stop);
+    file.setProgress([this](int percent) { emit modelLoadProgress(percent); });
+    Model model = WhisperStatePool::load(file, options.states);
+    const qint64 loadMs = timer.elapsed();
+    const qint64 rssAfterKb = ModelFile::residentKb();
+    if (!model || !model->isValid()) {
         qCritical() << "Failed to initialize whisper context from" << modelPath;
-    } else {
-        qDebug() << "Whisper re-initialized successfully";
-        DatabaseManager::instance().setSetting("model_path", modelPath);
+        emit modelFailed(modelPath, "Not a usable whisper model");
+        return;
+    }
+
+    QString reason;
+    QElapsedTimer selfTestTimer;
+    selfTestTimer.start();
+    if (options.selfTest && !selfTest(*model, reason)) {
+        qCritical() << "Model" << modelPath << "failed its self-test:" << reason << "- keeping the current model";
+        emit modelFailed(modelPath, reason);
+        return;
+    }
+    const qint64 selfTestMs = options.selfTest ? selfTestTimer.elapsed() : -1;
+
+    {
+        QMutexLocker locker(&mutex);
+        m_model = model; // The old context is freed when the last job using it finishes
+        m_servingPath = modelPath;
+        m_evictedPath.clear();
+        m_idleSince.start();
+        setResidency(Resident);
+        m_wake.wakeAll();
+    }
+    // Startup cost per loading path, to compare model_mmap on and off
+    qDebug() << "Whisper initialized successfully: loaded in" << loadMs << "ms ("
+             << (isMapped ? "mapped" : "read") << file.size() / (1024 * 1024) << "MB), RSS"
+             << rssBeforeKb / 1024 << "->" << rssAfterKb / 1024 << "MB, ready after self-test in" << timer.elapsed() << "ms";
+    emit modelReady(modelPath);
+
+    if (options.warmup) warmUp(*model, selfTestMs);
+    if (options.calibrate) calibrateThreads(*model, modelPath);
+}
+
+// Loader thread, model already serving. The self-test leaves the weights
+// paged in, but the first real job would still run cold at the serving
+// thread count and decode settings: its compute graph, ggml's thread start-up
+// and the decoder's caches. Two decodes of the reference clip take that cost
+// here, on an idle-priority thread so they only use otherwise idle cores.
+// A job that starts meanwhile aborts the warmup; it is warming the model itself.
+void InferenceWorker::warmUp(WhisperStatePool &model, qint64 selfTestMs)
+{
+    WhisperStatePool::Lease lease = model.tryAcquire();
+    if (!lease) return; // Already decoding
+
+    QVector<float> pcm = ModelCatalog::referenceClip().pcm;
+    if (pcm.isEmpty()) pcm = quietNoise(sampleRate * kSelfTestMs / 1000); // Encoder only, but still the slow part
+
+    DecodingPolicy policy;
+    {
+        QMutexLocker locker(&mutex);
+        policy = m_policy;
     }
+    policy.maxFallbacks = 0; // Fixed work, so the passes compare
+    whisper_full_params wparams = decodeParams(m_threads);
+    policy.apply(wparams);
+
+    struct Warmup {
+        const std::atomic<bool> *stop;
+        const std::atomic<quint64> *jobsStarted;
+        quint64 jobsBefore;
+    } warmup{&m_stop, &m_jobsStarted, m_jobsStarted};
+    wparams.abort_callback = [](void *userData) {
+        auto *w = static_cast<Warmup*>(userData);
+        return w->stop->load(std::memory_order_relaxed) || w->jobsStarted->load(std::memory_order_relaxed) != w->jobsBefore;
+    };
+    wparams.abort_callback_user_data = &warmup;
+
+    QVector<qint64> passMs;
+    QThread *thread = QThread::create([&]() {
+        for (int i = 0; i < kWarmupPasses; ++i) {
+            DecodingPolicy::Result result;
+            if (!policy.decode(model.context(), lease.state(), wparams, pcm.constData(), int(pcm.size()), result)) return;
+            passMs.append(result.ms);
+        }
+    });
+    thread->setObjectName("ModelWarmup");
+    thread->start(QThread::IdlePriority); // SCHED_IDLE on Linux; ggml's threads inherit it
+    thread->wait();
+    delete thread;
+
+    if (passMs.size() < kWarmupPasses) {
+        qDebug() << "Warmup interrupted by a transcription";
+        return;
+    }
+    QStringList passes;
+    if (selfTestMs >= 0) passes << QString("self-test %1 ms").arg(selfTestMs); // The coldest run
+    for (qint64 ms : passMs) passes << QString("%1 ms").arg(ms);
+    qDebug() << "Warmup:" << qint64(pcm.size()) * 1000 / sampleRate << "ms of audio at" << wparams.n_threads
+             << "threads, cold to warm:" << passes.join(", ");
+}
+
+// Loader thread, model already serving. A job running at the same time would
+// skew the timings, so such a sweep is thrown away and retried next launch.
+void InferenceWorker::calibrateThreads(WhisperStatePool &model, const QString &modelPath)
+{
+    const quint64 jobsBefore = m_jobsStarted;
+    QElapsedTimer timer;
+    timer.start();
+    const ThreadCalibrator::Result result = ThreadCalibrator::run(model, &m_stop);
+
+    QStringList timings;
+    for (const auto &timing : result.timings) timings << QString("%1:%2ms").arg(timing.first).arg(timing.second);
+    if (result.threads <= 0 || m_jobsStarted != jobsBefore) {
+        qDebug() << "Thread calibration discarded (interrupted)" << timings.join(' ');
+        return;
+    }
+    qDebug() << "Thread calibration:" << result.threads << "threads in" << timer.elapsed() << "ms -" << timings.join(' ');
+    if (m_threadOverride == 0) m_threads = result.threads;
+    emit threadsCalibrated(result.threads, ThreadCalibrator::cpuModel(), modelPath);
+}
+
+// Loader thread: a short decode must complete before the model may serve
+bool InferenceWorker::selfTest(WhisperStatePool &candidate, QString &reason)
+{
+    WhisperStatePool::Lease lease = candidate.acquire();
+    const QVector<float> pcm = quietNoise(sampleRate * kSelfTestMs / 1000);
+
+    struct SelfTest {
+        QDeadlineTimer deadline;
+        const std::atomic<bool> *stop;
+    } test{QDeadlineTimer(kSelfTestTimeoutMs), &m_stop};
+
+    whisper_full_params wparams = decodeParams(qMin(2, CpuTopology::instance().computeCpuCount()));
+    wparams.abort_callback = [](void *userData) {
+        auto *t = static_cast<SelfTest*>(userData);
+        return t->stop->load(std::memory_order_relaxed) || t->deadline.hasExpired();
+    };
+    wparams.abort_callback_user_data = &test;
+
+    if (whisper_full_with_state(candidate.context(), lease.state(), wparams, pcm.constData(), int(pcm.size())) != 0) {
+        reason = test.deadline.hasExpired() ? "Self-test transcription timed out" : "Self-test transcription failed";
+        return false;
+    }
+    // Noise may well decode to nothing; what a broken model shows is NaN or
+    // infinite token probabilities in whatever it did decode
+    for (int i = 0; i < whisper_full_n_segments_from_state(lease.state()); ++i) {
+        for (int j = 0; j < whisper_full_n_tokens_from_state(lease.state(), i); ++j) {
+            const whisper_token_data token = whisper_full_get_token_data_from_state(lease.state(), i, j);
+            if (!std::isfinite(token.p) || !std::isfinite(token.plog)) {
+                reason = "Self-test produced invalid token probabilities";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Called from the decoding thread between graph nodes, which doubles as the
+// sampling point for the core usage report
+bool InferenceWorker::shouldAbort(void *userData)
+{
+    auto *worker = static_cast<InferenceWorker*>(userData);
+    if (QThread::currentThread() == worker && worker->m_probing) worker->m_usage.sample();
+    return worker->m_stop.load(std::memory_order_relaxed);
+}
+
+bool InferenceWorker::shouldAbortPartial(void *userData)
+{
+    auto *worker = static_cast<InferenceWorker*>(userData);
+    return worker->m_stop.load(std::memory_order_relaxed) || worker->m_abortPartial.load(std::memory_order_relaxed);
 }
 
 void InferenceWorker::run()
 {
-    while (!m_stop) {
-        bool processFinal = false;
-        QVector<float> bufferToProcess;
-        
+    // ggml's compute threads are created by this one and inherit its affinity,
+    // so on a hybrid CPU every decode stays on the performance cores
+    CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+
+    // Sleeps on the condition variable: with no stream running there is no
+    // deadline at all, so an idle worker never wakes up
+    while (true) {
+        Job job;
+        AudioSource source;
+        bool restart = false;
+        Model model;
         {
             QMutexLocker locker(&mutex);
-            if (m_hasFinalRequest) {
-                bufferToProcess = m_finalProcessingBuffer;
-                m_finalProcessingBuffer.clear();
-                m_hasFinalRequest = false;
-                processFinal = true;
+            m_idleSince.start(); // The previous job, if any, just finished
+            // Jobs wait while the first model is still loading
+            auto jobReady = [this]() { return !m_jobs.isEmpty() && (m_model || !m_loading); };
+            while (!jobReady() && !m_stop && !(m_streamSource && m_nextPartial.hasExpired())) {
+                m_wake.wait(&mutex, m_streamSource ? m_nextPartial : QDeadlineTimer(QDeadlineTimer::Forever));
+            }
+            if (m_stop) break;
+            if (m_chunksReset) {
+                m_stitcher.clear();
+                m_chunkCount = 0;
+                m_chunksReset = false;
+            }
+            model = m_model; // Pinned for this job; a swap can't pull it out from under us
+            m_jobPolicy = m_policy;
+            if (jobReady()) {
+                job = m_jobs.dequeue();
+            } else {
+                source = m_streamSource;
+                restart = m_streamRestart;
+                m_streamRestart = false;
+                m_abortPartial = false;
             }
         }
-        
-        if (processFinal && !bufferToProcess.isEmpty() && ctx) {
-             qDebug() << "Processing final transcription for" << bufferToProcess.size() / 16000.0 << "seconds of audio";
-             
-             whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-             wparams.print_progress = false;
-             wparams.print_special = false;
-             wparams.print_realtime = false;
-             wparams.print_timestamps = false;
-             wparams.translate = false;
-             wparams.language = "en";
-             wparams.n_threads = qMin(4, QThread::idealThreadCount()); // Limit to 4 threads to prevent Flatpak/Sandbox contention
-             wparams.offset_ms = 0;
-            
-             if (whisper_full(ctx, wparams, bufferToProcess.data(), bufferToProcess.size()) != 0) {
-                 qCritical() << "failed to process audio";
-                 emit finalResultReady("");
-             } else {
-                 const int n_segments = whisper_full_n_segments(ctx);
-                 QString fullText = "";
-                 for (int i = 0; i < n_segments; ++i) {
-                     const char *text = whisper_full_get_segment_text(ctx, i);
-                     fullText += QString::fromUtf8(text);
-                 }
-                 qDebug() << "Final Result ready:" << fullText.trimmed();
-                 emit finalResultReady(fullText.trimmed());
-             }
+
+        ++m_jobsStarted;
+        // A state from the model's pool: its buffers were allocated once, not per job
+        WhisperStatePool::Lease lease = model ? model->acquire() : WhisperStatePool::Lease();
+        ctx = lease ? model->context() : nullptr;
+        state = lease.state();
+        m_jobModel = lease ? model.get() : nullptr;
+        if (!source) {
+            // Whether the warmup did its job shows in the first job on each model
+            const bool firstOnModel = ctx && job.kind != Job::FinishChunks && model.get() != m_lastJobModel;
+            if (firstOnModel) m_lastJobModel = model.get();
+            QElapsedTimer jobTimer;
+            jobTimer.start();
+            const bool probe = ctx && job.kind != Job::FinishChunks;
+            if (probe) {
+                m_usage.begin();
+                m_probing = true;
+            }
+            switch (job.kind) {
+            case Job::Final:
+                transcribeFinal(job.audio);
+                break;
+            case Job::Chunk:
+                transcribeChunk(job.audio, job.overlapped);
+                break;
+            case Job::FinishChunks:
+                qDebug() << "Stitched" << m_chunkCount << "chunks:" << m_stitcher.text();
+                emit finalResultReady(m_stitcher.text());
+                m_stitcher.clear();
+                m_chunkCount = 0;
+                break;
+            }
+            if (probe) {
+                m_probing = false;
+                qDebug() << "Decode ran on CPUs:" << CpuTopology::instance().classify(m_usage.end());
+            }
+            if (firstOnModel) qDebug() << "First job on this model took" << jobTimer.elapsed() << "ms";
+            ctx = nullptr;
+            state = nullptr;
+            m_jobModel = nullptr;
+            continue;
         }
-        
-        QThread::msleep(100);
+
+        if (restart) resetStream();
+        transcribePartial(source());
+        ctx = nullptr;
+        state = nullptr;
+        m_jobModel = nullptr;
+
+        QMutexLocker locker(&mutex);
+        if (m_streamSource) m_nextPartial = QDeadlineTimer(m_stepMs);
+    }
+}
+
+whisper_full_params InferenceWorker::decodeParams(int threads)
+{
+    whisper_full_params wparams = DecodingPolicy::baseParams(threads);
+    wparams.abort_callback = &InferenceWorker::shouldAbort; // Shutdown doesn't wait for a long decode
+    wparams.abort_callback_user_data = this;
+    return wparams;
+}
+
+// Worker thread: final and chunk jobs decode under the job's policy, which
+// bounds temperature fallback by its latency budget
+bool InferenceWorker::decodeWithPolicy(const float *pcm, int samples, whisper_full_params wparams, QString &text)
+{
+    m_jobPolicy.apply(wparams);
+    DecodingPolicy::Result result;
+    if (!m_jobPolicy.decode(ctx, state, wparams, pcm, samples, result)) return false;
+    text = result.text;
+
+    ++m_policyJobs;
+    if (result.budgetHit) ++m_budgetHits;
+    qDebug() << "Decode:" << qint64(samples) * 1000 / sampleRate << "ms of audio in" << result.ms << "ms, encoder"
+             << qRound(result.encodeMs) << "ms"
+             << (result.audioCtx > 0 ? QString("(audio_ctx %1)").arg(result.audioCtx) : QString("(full window)"));
+    if (result.fallbacks > 0 || result.budgetHit) {
+        qDebug() << "Decode:" << result.fallbacks << "fallbacks," << result.unresolved << "segments below threshold,"
+                 << result.ms << "ms" << (result.budgetHit ? "- budget hit" : "") << "(budget hit in" << m_budgetHits
+                 << "of" << m_policyJobs << "jobs this session)";
+    }
+    emit decodeBudgetStats(m_policyJobs, m_budgetHits);
+    return true;
+}
+
+void InferenceWorker::transcribeFinal(const RecordingView &recording)
+{
+    if (recording.isEmpty() || !ctx) {
+        // Nothing to decode (VAD found no speech, or no model): skip whisper_full entirely
+        qDebug() << (recording.isEmpty() ? "No speech captured, skipping inference" : "No model loaded, skipping inference");
+        emit finalResultReady("");
+        return;
+    }
+
+    qDebug() << "Processing final transcription for" << recording.durationSeconds() << "seconds of audio";
+    if (recording.size() > LongFormTranscriber::kMinSamples && m_jobModel) {
+        transcribeLongForm(recording);
+        return;
+    }
+
+    // whisper_full wants one contiguous PCM array. Use the view in place when
+    // it already is one, otherwise gather once into a scratch buffer.
+    const float *pcm = recording.contiguousData();
+    if (!pcm) {
+        m_pcmScratch.resize(recording.size());
+        recording.copyTo(m_pcmScratch.data());
+        pcm = m_pcmScratch.constData();
+    }
+
+    QString fullText;
+    if (!decodeWithPolicy(pcm, int(recording.size()), decodeParams(m_threads), fullText)) {
+        qCritical() << (m_stop ? "Transcription aborted for shutdown" : "failed to process audio");
+        emit finalResultReady("");
+    } else {
+        qDebug() << "Final Result ready:" << fullText;
+        emit finalResultReady(fullText);
+    }
+    m_pcmScratch = QVector<float>(); // Don't hold a whole take's worth of PCM while idle
+}
+
+// Worker thread: a long take split at pauses and decoded a few chunks at a
+// time. The lanes share the configured threads between them instead of every
+// decode getting all of them, e.g. 4 chunks x 2 threads for 8, and there are
+// never more lanes than pooled states (whisper_states).
+void InferenceWorker::transcribeLongForm(const RecordingView &recording)
+{
+    const int threads = m_threads;
+    const int parallel = qMin(LongFormTranscriber::parallelismFor(threads), m_jobModel->maxStates());
+    whisper_full_params wparams = decodeParams(qMax(1, threads / parallel));
+    m_jobPolicy.apply(wparams);
+    wparams.no_context = true; // Chunks are independent; nothing earlier to carry over
+
+    LongFormTranscriber::Stats stats;
+    const QString text = LongFormTranscriber::transcribe(*m_jobModel, state, recording, m_jobPolicy, wparams, parallel,
+                                                         &m_stop, &stats);
+    if (m_stop) {
+        qCritical() << "Transcription aborted for shutdown";
+        emit finalResultReady("");
+        return;
+    }
+
+    ++m_policyJobs;
+    if (stats.budgetHits > 0) ++m_budgetHits;
+    const double audioMs = recording.durationSeconds() * 1000.0;
+    qDebug() << "Long-form:" << stats.chunks << "chunks," << stats.parallel << "at a time x" << stats.threadsPerChunk
+             << "threads," << qRound(audioMs) << "ms of audio in" << stats.ms << "ms ("
+             << (stats.ms > 0 ? audioMs / stats.ms : 0.0) << "x real time)";
+    if (stats.budgetHits > 0) qDebug() << "Long-form:" << stats.budgetHits << "chunks hit the fallback budget";
+    emit decodeBudgetStats(m_policyJobs, m_budgetHits);
+
+    qDebug() << "Final Result ready:" << text;
+    emit finalResultReady(text);
+}
+
+// Worker thread: one chunk of a pipelined take, decoded while recording goes on
+void InferenceWorker::transcribeChunk(const RecordingView &chunk, bool overlapped)
+{
+    if (chunk.isEmpty() || !ctx) return;
+
+    const float *pcm = chunk.contiguousData();
+    if (!pcm) {
+        m_pcmScratch.resize(chunk.size());
+        chunk.copyTo(m_pcmScratch.data());
+        pcm = m_pcmScratch.constData();
+    }
+
+    whisper_full_params wparams = decodeParams(m_threads);
+    wparams.no_context = true;
+    m_prompt = m_stitcher.tail(kPromptChars).toUtf8(); // Continuity across the cut
+    wparams.initial_prompt = m_prompt.isEmpty() ? nullptr : m_prompt.constData();
+
+    QElapsedTimer timer;
+    timer.start();
+    QString text;
+    if (!decodeWithPolicy(pcm, int(chunk.size()), wparams, text)) {
+        qCritical() << "failed to process chunk";
+        return;
     }
+    m_stitcher.append(text, overlapped);
+    ++m_chunkCount;
+    qDebug() << "Chunk" << m_chunkCount << "(" << chunk.durationSeconds() << "s ) decoded in" << timer.elapsed() << "ms";
+}
+
+void InferenceWorker::resetStream()
+{
+    m_committedSamples = 0;
+    m_lastDecodedSize = 0;
+    m_committedText.clear();
+    m_decodeMs = 0.0;
+
+    // 4 cores or fewer: leave one for capture and the UI, and start with a slower
+    // cadence. A hybrid CPU already keeps those on the efficiency cores.
+    const int cores = CpuTopology::instance().computeCpuCount();
+    const bool roomy = cores > 4 || CpuTopology::instance().isHybrid();
+    m_streamThreads = roomy ? m_threads.load() : qMax(1, qMin(m_threads.load(), cores - 1));
+    QMutexLocker locker(&mutex);
+    m_stepMs = roomy ? 300 : 600;
+}
+
+// Worker thread: decode everything after the commit point. Consecutive windows
+// overlap (each re-reads the whole uncommitted tail), so the tail text firms
+// up as more context arrives; once the window is long enough, every segment
+// but the last is committed and the window slides past it.
+void InferenceWorker::transcribePartial(const RecordingView &take)
+{
+    if (!ctx || take.size() <= m_lastDecodedSize) return; // Nothing new since the last pass
+    m_lastDecodedSize = take.size();
+
+    const RecordingView window = take.mid(m_committedSamples);
+    if (window.size() < sampleRate / 10) return;
+
+    // Pad short windows with silence rather than wait a whole second for the first words
+    const qint64 minSamples = qint64(sampleRate) * kMinWindowMs / 1000;
+    const float *pcm = window.size() >= minSamples ? window.contiguousData() : nullptr;
+    qint64 pcmSize = qMax(window.size(), minSamples);
+    if (!pcm) {
+        m_windowScratch.resize(pcmSize);
+        window.copyTo(m_windowScratch.data());
+        std::fill(m_windowScratch.begin() + window.size(), m_windowScratch.end(), 0.0f);
+        pcm = m_windowScratch.constData();
+    }
+
+    whisper_full_params wparams = decodeParams(m_streamThreads);
+    wparams.no_context = true;
+    wparams.abort_callback = &InferenceWorker::shouldAbortPartial; // Never hold up the final pass
+    wparams.temperature_inc = 0.0f; // No fallback: the next window re-reads this audio anyway
+    m_prompt = m_committedText.right(kPromptChars).toUtf8();
+    wparams.initial_prompt = m_prompt.isEmpty() ? nullptr : m_prompt.constData();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (whisper_full_with_state(ctx, state, wparams, pcm, int(pcmSize)) != 0) return; // Aborted or failed; the next pass retries
+    const qint64 decodeMs = timer.elapsed();
+
+    const qint64 windowMs = window.size() * 1000 / sampleRate;
+    const int n = whisper_full_n_segments_from_state(state);
+    int commitCount = 0;
+    qint64 commitToMs = 0;
+    if (windowMs >= kMaxWindowMs) {
+        // Forced: commit it all, or let a long stretch without speech go
+        commitCount = n;
+        commitToMs = n > 0 ? qMin(windowMs, whisper_full_get_segment_t1_from_state(state, n - 1) * 10) : windowMs - kMinWindowMs;
+    } else if (windowMs >= kCommitWindowMs && n > 1) {
+        commitCount = n - 1;
+        commitToMs = whisper_full_get_segment_t0_from_state(state, n - 1) * 10; // t0/t1 are in 10 ms units
+    }
+    if (commitToMs <= 0) commitCount = 0; // A commit must move the window, or its text repeats
+
+    QString committed, partial;
+    for (int i = 0; i < n; ++i) {
+        (i < commitCount ? committed : partial) += QString::fromUtf8(whisper_full_get_segment_text_from_state(state, i));
+    }
+    m_committedSamples += commitToMs * sampleRate / 1000;
+
+    if (!committed.trimmed().isEmpty()) {
+        m_committedText += committed;
+        emit transcriptionUpdated(committed.trimmed(), true);
+    }
+    emit transcriptionUpdated(partial.trimmed(), false);
+
+    // Adapt the cadence: keep step + decode near the target while decodes are
+    // cheap, and back off to ~50% duty when they aren't, so a slow machine
+    // gets slower partials rather than a starved capture thread and UI
+    m_decodeMs = m_decodeMs > 0.0 ? 0.7 * m_decodeMs + 0.3 * decodeMs : double(decodeMs);
+    const int step = m_decodeMs < kPartialTargetMs - kMinStepMs ? int(kPartialTargetMs - m_decodeMs) : int(m_decodeMs);
+
+    QMutexLocker locker(&mutex);
+    m_partialLatencies.append(m_stepMs + decodeMs);
+    m_stepMs = qBound(kMinStepMs, step, kMaxStepMs);
 }
@@ -0,0 +1,166 @@
+#include "longformtranscriber.h"
+#include "voiceactivitydetector.h"
+#include "transcriptstitcher.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <vector>
+
+static const int kSampleRate = 16000;
+static const qint64 kMaxChunk = 28 * kSampleRate; // Under one 30 s window, with room for the padding
+static const qint64 kMinChunk = 10 * kSampleRate; // Shorter chunks waste most of their encoder pass
+static const qint64 kPad = kSampleRate / 5;       // Kept on each side of speech, like the capture trim
+static const qint64 kOverlap = kSampleRate;       // Shared by hard cuts; the stitcher drops the repeat
+static const int kVadBlock = 16384;
+
+QVector<LongFormTranscriber::Chunk> LongFormTranscriber::split(const RecordingView &audio)
+{
+    const qint64 total = audio.size();
+    VoiceActivityDetector vad(kSampleRate);
+    std::vector<float> block(kVadBlock);
+    for (qint64 at = 0; at < total; at += kVadBlock) {
+        const RecordingView part = audio.mid(at, qMin<qint64>(kVadBlock, total - at));
+        part.copyTo(block.data());
+        vad.process(block.data(), int(part.size()));
+    }
+    vad.finish();
+
+    // Pauses between speech segments; the capture already decided there is
+    // speech, so a take the VAD hears none in is decoded whole
+    std::vector<VoiceActivityDetector::Segment> speech = vad.segments();
+    if (speech.empty()) speech.push_back({0, total});
+
+    QVector<Chunk> chunks;
+    qint64 start = qMax<qint64>(0, speech.front().start - kPad);
+    const qint64 end = qMin<qint64>(total, speech.back().end + kPad);
+    bool overlapped = false;
+    while (start < end) {
+        // The overlap of a hard cut can reach back into a pause: start where it ends
+        for (size_t i = 1; i < speech.size(); ++i) {
+            if (speech[i - 1].end <= start && start < speech[i].start - kPad) {
+                start = speech[i].start - kPad;
+                break;
+            }
+        }
+        if (end - start <= kMaxChunk) {
+            chunks.append({start, end - start, overlapped});
+            break;
+        }
+        const qint64 limit = start + kMaxChunk;
+
+        // The widest pause after start whose middle lands between kMinChunk and
+        // kMaxChunk in; failing that, one the cut at kMaxChunk would fall into
+        qint64 gapFrom = -1, gapTo = -1;
+        for (size_t i = 1; i < speech.size(); ++i) {
+            const qint64 from = speech[i - 1].end, to = speech[i].start;
+            const qint64 middle = (from + to) / 2;
+            if (from < start || middle < start + kMinChunk) continue;
+            if (middle > limit) break;
+            if (to - from >= gapTo - gapFrom) {
+                gapFrom = from;
+                gapTo = to;
+            }
+        }
+        if (gapFrom < 0) {
+            for (size_t i = 1; i < speech.size(); ++i) {
+                const qint64 from = speech[i - 1].end, to = speech[i].start;
+                if (from >= start && from < limit && to > limit) {
+                    gapFrom = from;
+                    gapTo = to;
+                    break;
+                }
+            }
+        }
+
+        if (gapFrom >= 0) {
+            const qint64 cut = qMin(qMin((gapFrom + gapTo) / 2, gapFrom + kPad), limit);
+            Q_ASSERT(cut > start);
+            if (cut > start) chunks.append({start, cut - start, overlapped});
+            start = qMax(qMax(cut, start + 1), gapTo - kPad); // Skip the rest of the pause
+            overlapped = false;
+        } else {
+            // Nothing but speech for kMaxChunk: cut anyway and overlap
+            chunks.append({start, kMaxChunk, overlapped});
+            start = limit - kOverlap;
+            overlapped = true;
+        }
+    }
+    return chunks;
+}
+
+int LongFormTranscriber::parallelismFor(int threads)
+{
+    return qBound(1, threads / 2, kMaxParallel);
+}
+
+QString LongFormTranscriber::transcribe(WhisperStatePool &pool, whisper_state *firstState, const RecordingView &audio,
+                                        const DecodingPolicy &policy, const whisper_full_params &wparams, int parallel,
+                                        const std::atomic<bool> *cancel, Stats *stats)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<Chunk> chunks = split(audio);
+    if (chunks.isEmpty() || !firstState) return QString();
+
+    // One state per lane: the caller's, then idle pooled ones, created up to
+    // the pool's cap; fewer lanes if the others are busy (a partial decode)
+    QVector<whisper_state*> states{firstState};
+    std::vector<WhisperStatePool::Lease> leases;
+    const int lanes = qMin(qBound(1, parallel, int(chunks.size())), pool.maxStates());
+    while (states.size() < lanes) {
+        WhisperStatePool::Lease lease = pool.tryAcquire();
+        if (!lease) break;
+        states.append(lease.state());
+        leases.push_back(std::move(lease));
+    }
+
+    // Lanes take the next chunk as they finish, so uneven chunks balance out
+    std::vector<QString> texts(chunks.size());
+    std::atomic<int> next{0};
+    std::atomic<int> budgetHits{0};
+    auto lane = [&](whisper_state *state) {
+        std::vector<float> scratch;
+        for (int i = next++; i < chunks.size(); i = next++) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return;
+            const RecordingView view = audio.mid(chunks[i].start, chunks[i].length);
+            const float *pcm = view.contiguousData();
+            if (!pcm) {
+                scratch.resize(view.size());
+                view.copyTo(scratch.data());
+                pcm = scratch.data();
+            }
+            DecodingPolicy::Result result;
+            if (!policy.decode(pool.context(), state, wparams, pcm, int(view.size()), result)) {
+                qWarning() << "Long-form chunk" << i + 1 << "of" << chunks.size() << "failed";
+                continue;
+            }
+            texts[i] = result.text;
+            if (result.budgetHit) ++budgetHits;
+        }
+    };
+
+    // ggml's compute threads inherit the caller's affinity through these
+    QVector<QThread*> helpers;
+    for (int i = 1; i < states.size(); ++i) {
+        QThread *helper = QThread::create(lane, states.at(i));
+        helper->start();
+        helpers.append(helper);
+    }
+    lane(firstState);
+    for (QThread *helper : helpers) {
+        helper->wait();
+        delete helper;
+    }
+
+    TranscriptStitcher stitcher;
+    for (int i = 0; i < chunks.size(); ++i) stitcher.append(texts[i], chunks[i].overlapped);
+
+    if (stats) {
+        stats->chunks = chunks.size();
+        stats->parallel = states.size();
+        stats->threadsPerChunk = wparams.n_threads;
+        stats->budgetHits = budgetHits;
+        stats->ms = timer.elapsed();
+    }
+    return stitcher.text();
+}
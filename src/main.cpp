@@ -4,10 +4,53 @@
 #include "mainwindow.h"
 #include "setupwizard.h"
 #include "databasemanager.h"
+#include "dspbenchmark.h"
+#include "decoderbenchmark.h"
+#include "cputopology.h"
+#include "modelcatalog.h"
 #include <QDir>
 
 int main(int argc, char *argv[])
 {
+    // Headless microbenchmarks: no display, no single-instance guard
+    for (int i = 1; i < argc; ++i) {
+        if (QString(argv[i]) == "--bench-audio") {
+            return DspBenchmark::runConversion();
+        }
+        if (QString(argv[i]) == "--bench-dsp" || QString(argv[i]) == "--bench-audio-ctx"
+            || QString(argv[i]) == "--bench-long-form") {
+            QCoreApplication app(argc, argv); // For settings and the bundled model path
+            app.setApplicationName("com.toice.app");
+            app.setOrganizationName("Toice");
+            QString corpusDir, modelPath;
+            for (int j = i + 1; j < argc; ++j) {
+                const QString arg = argv[j];
+                if (arg == "--model" && j + 1 < argc) modelPath = argv[++j];
+                else if (!arg.startsWith("--")) corpusDir = arg;
+            }
+            if (QString(argv[i]) == "--bench-audio-ctx") return DecoderBenchmark::runAudioContext(corpusDir, modelPath);
+            if (QString(argv[i]) == "--bench-long-form") return DecoderBenchmark::runLongForm(corpusDir, modelPath);
+            return DspBenchmark::runDsp(corpusDir, modelPath);
+        }
+        if (QString(argv[i]) == "--bench-models") {
+            QCoreApplication app(argc, argv);
+            app.setApplicationName("com.toice.app");
+            app.setOrganizationName("Toice");
+            double floor = 0.0;
+            for (int j = i + 1; j + 1 < argc; ++j) {
+                if (QString(argv[j]) == "--floor") floor = QString(argv[j + 1]).toDouble();
+            }
+            if (floor <= 0.0 && DatabaseManager::instance().init()) {
+                floor = DatabaseManager::instance().getSetting("model_accuracy_floor", "90").toDouble();
+            }
+            return ModelCatalog::runBenchmark(floor);
+        }
+    }
+
+    // Hybrid CPUs: the GUI, and every thread it starts that doesn't pin itself,
+    // stays on the efficiency cores; inference pins itself to the performance ones
+    CpuTopology::instance().pinCurrentThread(CpuTopology::Efficiency);
+
     // Force X11 (xcb) even on Wayland to allow absolute positioning
     qputenv("QT_QPA_PLATFORM", "xcb");
     
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "settingsdialog.h"
 #include "databasemanager.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -14,11 +15,14 @@
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusMessage>
 #include <QApplication>
+#include <QMessageBox>
+#include <QFile>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
 #include <QColor>
 #include <QCloseEvent>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -85,8 +89,40 @@ MainWindow::MainWindow(QWidget *parent)
     });
     
     // Initialize Inference Worker
+    // The model loads on the worker thread; recording works meanwhile and its
+    // transcription runs as soon as the model is resident
     inference = new InferenceWorker(this);
-    // [REMOVED LIVE UPDATES CONNECTION]
+    connect(inference, &InferenceWorker::transcriptionUpdated, this, &MainWindow::updateTranscription);
+    connect(inference, &InferenceWorker::modelLoadProgress, this, [=](int percent) {
+        // A replacement loads next to the current model, which keeps transcribing
+        setModelStatus(QString(m_modelLoaded ? "Switching model %1%" : "Loading model %1%").arg(percent), "#f59e0b");
+    });
+    connect(inference, &InferenceWorker::modelReady, this, [=](QString modelPath) {
+        m_modelLoaded = true;
+        setModelStatus("Model ready", "#22c55e");
+        if (modelPath == m_requestedModelPath) {
+            DatabaseManager::instance().setSetting("model_path", modelPath);
+            m_requestedModelPath.clear();
+        }
+    });
+    connect(inference, &InferenceWorker::modelFailed, this, [=](QString modelPath, QString reason) {
+        if (m_modelLoaded) {
+            setModelStatus("Kept previous model", "#22c55e"); // Rolled back, still usable
+        } else {
+            setModelStatus("Model failed to load", "#ef4444");
+        }
+        m_modelStatus->setToolTip(reason + ": " + modelPath);
+        if (modelPath == m_requestedModelPath) m_requestedModelPath.clear();
+    });
+    connect(inference, &InferenceWorker::residencyChanged, this, [=](QString residency) {
+        if (residency == "evicted") {
+            // Freed while idle; the next take reloads it while recording
+            m_modelLoaded = false;
+            setModelStatus("Model unloaded (idle)", "#a1a1aa");
+        }
+        emit modelResidencyChanged(residency);
+    });
+    inference->loadModel(InferenceWorker::configuredModelPath());
     inference->start();
     
     // 1. Create Overlay FIRST
@@ -105,15 +141,19 @@ MainWindow::MainWindow(QWidget *parent)
     // 2. Create Audio SECOND
     audio = new AudioRecorder(this);
     if (audio) {
-        connect(audio, &AudioRecorder::audioLevel, this, &MainWindow::updateAudioLevel);
+        // Meters are polled once per display frame while recording, not pushed per buffer
+        m_meterTimer = new QTimer(this);
+        m_meterTimer->setInterval(16);
+        connect(m_meterTimer, &QTimer::timeout, this, &MainWindow::updateMeters);
+        // Hot-plug and default-device changes switch the recorder on their own
+        connect(audio, &AudioRecorder::inputsChanged, this, &MainWindow::refreshDevices);
+        connect(audio, &AudioRecorder::deviceChanged, this, &MainWindow::refreshDevices);
+        m_transcriptionMode = DatabaseManager::instance().getSetting("transcription_mode", "batch");
+        // Pipelined mode: chunks go straight from the audio pipeline thread to the worker's queue
+        audio->setChunkSink([this](const RecordingView &chunk, bool overlapped) {
+            inference->addChunk(chunk, overlapped);
+        });
         
-        // 3. Connect to overlay only if it exists
-        if (overlay) {
-            connect(audio, &AudioRecorder::audioLevel, overlay, &OverlayWidget::setAudioLevel);
-            connect(audio, &AudioRecorder::frequencyBands, overlay, &OverlayWidget::setFrequencyBands);
-            qDebug() << "Connected levels to overlay";
-        }
-
         // 4. Final Result Handling
         connect(inference, &InferenceWorker::finalResultReady, this, [=](QString text) {
             // If overlay is visible, give it a small delay to ensure Finalizing animation renders
@@ -122,8 +162,25 @@ MainWindow::MainWindow(QWidget *parent)
             int remaining = qMax(0, 1000 - (int)elapsed);
             
             qDebug() << "finalResultReady: elapsed =" << elapsed << "ms, overlay visible =" << overlay->isVisible() << ", delay =" << remaining;
+
+            // Stop-to-text latency per transcription mode (before the minimum animation delay)
+            if (!m_takeMode.isEmpty()) {
+                QVector<qint64> &samples = m_stopLatencies[m_takeMode];
+                samples.append(elapsed);
+                QVector<qint64> sorted = samples;
+                std::sort(sorted.begin(), sorted.end());
+                qDebug() << "Stop-to-clipboard latency (" << m_takeMode << "): p50" << sorted[sorted.size() / 2]
+                         << "ms, p95" << sorted[qMin(sorted.size() - 1, int(sorted.size() * 0.95))] << "ms over" << sorted.size() << "takes";
+                m_takeMode.clear();
+            }
             
             auto finalizeAction = [=]() {
+                // The take has its result now; its journal no longer needs recovering
+                if (m_pendingJournal) {
+                    m_pendingJournal->markTranscribed();
+                    m_pendingJournal.reset();
+                }
+
                 if (!text.isEmpty()) {
                     QGuiApplication::clipboard()->setText(text);
                     qDebug() << "Final transcription synced to clipboard:" << text;
@@ -171,6 +228,10 @@ MainWindow::MainWindow(QWidget *parent)
                     btnCopy->hide();
                     btnClear->hide();
                 }
+
+                if (!m_recoveryQueue.isEmpty()) {
+                    QTimer::singleShot(0, this, &MainWindow::transcribeNextRecovered);
+                }
             };
 
             if (remaining > 0) {
@@ -183,10 +244,13 @@ MainWindow::MainWindow(QWidget *parent)
 
 
 
+    // 5. Offer takes left behind by a crash
+    QTimer::singleShot(0, this, &MainWindow::recoverJournals);
+
     // 6. DBus Registration for Global Control
     QDBusConnection bus = QDBusConnection::sessionBus();
     if (bus.registerService("com.toice.app")) {
-        bus.registerObject("/", this, QDBusConnection::ExportAllSlots);
+        bus.registerObject("/", this, QDBusConnection::ExportAllSlots | QDBusConnection::ExportScriptableSignals);
         qDebug() << "DBus service registered: com.toice.app";
     }
 }
@@ -226,25 +290,85 @@ void MainWindow::stopFromRemote()
     }
 }
 
+QString MainWindow::modelResidency()
+{
+    return InferenceWorker::residencyName(inference->residency());
+}
+
 MainWindow::~MainWindow() {}
 
 void MainWindow::onDeviceChanged(int index)
 {
     if (index >= 0 && index < devices.size()) {
-        audio->setDevice(devices[index]);
-        if (isRecording) audio->start();
+        audio->setDevice(devices[index]); // Keeps capturing if a take or the pre-roll is running
+    }
+}
+
+// Journaled takes that never got a result (crash, power loss, killed session)
+void MainWindow::recoverJournals()
+{
+    const QStringList paths = RecordingJournal::pending(RecordingJournal::defaultDirectory());
+    if (paths.isEmpty()) return;
+
+    double seconds = 0.0;
+    for (const QString &path : paths) {
+        if (auto journal = RecordingJournal::open(path)) seconds += journal->size() / double(journal->sampleRate());
+    }
+
+    const auto answer = QMessageBox::question(this, "Recover Recording",
+        QString("Toice found %1 unfinished recording(s) from a previous session (%2 s of audio).\n"
+                "Transcribe them now?").arg(paths.size()).arg(seconds, 0, 'f', 1));
+    if (answer != QMessageBox::Yes) {
+        for (const QString &path : paths) QFile::remove(path);
+        return;
+    }
+
+    m_recoveryQueue = paths;
+    transcribeNextRecovered();
+}
+
+void MainWindow::transcribeNextRecovered()
+{
+    while (!m_recoveryQueue.isEmpty() && !isRecording && !m_isFinalizing) {
+        std::shared_ptr<RecordingJournal> journal = RecordingJournal::open(m_recoveryQueue.takeFirst());
+        if (!journal) continue;
+
+        qDebug() << "Transcribing recovered take" << journal->path() << "-" << journal->size() << "samples";
+        m_pendingJournal = journal;
+        m_isFinalizing = true;
+        m_finalizationStartTime.start();
+        btnRecord->setText("Processing...");
+        inference->requestFinalTranscription(journal->view()); // Straight from the mapping
+        return;
     }
 }
 
+void MainWindow::refreshDevices()
+{
+    // Repopulate without triggering onDeviceChanged, selecting the active input
+    const QAudioDevice active = audio ? audio->device() : QMediaDevices::defaultAudioInput();
+    QSignalBlocker blocker(deviceSelector);
+    deviceSelector->clear();
+    devices = AudioRecorder::availableDevices();
+    for (const auto &dev : devices) deviceSelector->addItem(dev.description());
+    const int index = devices.indexOf(active);
+    if (index >= 0) deviceSelector->setCurrentIndex(index);
+}
+
 // [Modified toggleRecording signature]
 void MainWindow::toggleRecording(bool useOverlay)
 {
+    const qint64 triggerNs = AudioRecorder::nowNs(); // Hotkey, button or D-Bus: latency is measured from here
     if (m_isFinalizing) return;
 
     if (isRecording) {
         // STOPPING
         m_finalizationStartTime.start(); // Start timing the loading phase
         audio->stop();
+        inference->stopStreaming();
+        m_meterTimer->stop();
+        audio->setMeteringActive(false);
+        audioMeter->setValue(0);
         isRecording = false;
         m_isFinalizing = true;
         
@@ -261,10 +385,16 @@ void MainWindow::toggleRecording(bool useOverlay)
         // Note: Don't forcibly hide overlay here - let it complete its animation
         // The overlay will hide itself after success message animation (see overlaywidget.cpp)
         
-        // [2] TRIGGER SINGLE-PASS TRANSCRIPTION
-        QVector<float> fullRecordedBuffer = audio->getRecordedAudio();
-        qDebug() << "Captured full buffer for transcription:" << fullRecordedBuffer.size() << "samples";
-        inference->requestFinalTranscription(fullRecordedBuffer);
+        // [2] TRIGGER TRANSCRIPTION
+        m_pendingJournal = audio->journal();
+        if (m_takeMode == "pipelined") {
+            // Earlier chunks are already decoded or queued; stop() just queued the tail
+            inference->finishChunks();
+        } else {
+            RecordingView recording = audio->getSpeechAudio(); // Empty when no speech was captured
+            qDebug() << "Captured buffer for transcription:" << recording.size() << "samples";
+            inference->requestFinalTranscription(recording);
+        }
         
         // [3] Log to History (Rich Format)
         // Get Formatted Time for UI
@@ -291,11 +421,21 @@ void MainWindow::toggleRecording(bool useOverlay)
         
     } else {
         // STARTING
+        m_takeMode = m_transcriptionMode;
+        audio->setChunking(m_takeMode == "pipelined");
+        audio->start(triggerNs); // First, so the take starts as close to the hotkey as possible
+        inference->wakeModel(); // An evicted model reloads while the user speaks
+        m_meterTimer->start();
         m_usingOverlay = useOverlay; // Store state for this session
 
         inference->clear();
+        m_liveCommitted.clear();
+        m_livePartial.clear();
+        if (m_takeMode == "streaming") {
+            // Called on the worker thread; the recorder's views are safe to take from there
+            inference->startStreaming([this]() { return audio->getRecordedAudio(); });
+        }
         liveLabel->setText("Listening...");
-        audio->start();
         btnRecord->setText("⏹ Stop Recording");
         btnRecord->setStyleSheet("background: #ef4444; color: white; padding: 8px 16px; border-radius: 4px; border:none;");
         isRecording = true;
@@ -339,16 +479,25 @@ void MainWindow::typeText()
     QProcess::startDetached("xdotool", QStringList() << "type" << "--delay" << "10" << text);
 }
 
-void MainWindow::updateAudioLevel(float level)
+void MainWindow::updateMeters()
 {
-    // Level is 0.0 to 1.0 (mostly small values)
-    int val = static_cast<int>(level * 1000); // Scale up
-    if (val > 100) val = 100;
-    audioMeter->setValue(val);
-    
+    const bool windowVisible = isVisible() && !isMinimized();
+    const bool overlayVisible = overlay && overlay->isVisible();
+    audio->setMeteringActive(windowVisible || overlayVisible); // No spectrum work for nobody
+
+    MeterSnapshot meter;
+    if (!audio->latestMeter(meter)) return; // Nothing new since the last frame
+
+    if (windowVisible) {
+        // Level is 0.0 to 1.0 (mostly small values)
+        int val = static_cast<int>(meter.peak * 1000); // Scale up
+        if (val > 100) val = 100;
+        if (audioMeter->value() != val) audioMeter->setValue(val);
+    }
+
     // Pass raw level to overlay for visualization
-    if (overlay && overlay->isVisible()) {
-        overlay->setAudioLevel(level); // Pass raw 0.0-1.0 level
+    if (overlayVisible) {
+        overlay->setMeter(meter);
     }
 }
 
@@ -441,6 +590,11 @@ void MainWindow::setupUi()
     phTitle->setStyleSheet("font-size: 11px; font-weight: 700; color: #71717a; letter-spacing: 0.5px;");
     phLayout->addWidget(phTitle);
     phLayout->addStretch();
+
+    // Model status chip
+    m_modelStatus = new QLabel();
+    phLayout->addWidget(m_modelStatus);
+    setModelStatus("Loading model", "#f59e0b");
     
     // Draw Mic Helper
     auto drawMic = [](QPainter& p) {
@@ -625,8 +779,7 @@ void MainWindow::setupUi()
     arrowIcon->setStyleSheet("border: none;");
     micLayout->addWidget(arrowIcon);
     
-    devices = AudioRecorder::availableDevices();
-    for (const auto &dev : devices) deviceSelector->addItem(dev.description());
+    refreshDevices();
     connect(deviceSelector, qOverload<int>(&QComboBox::currentIndexChanged), this, &MainWindow::onDeviceChanged);
     micLayout->addWidget(deviceSelector);
     
@@ -765,6 +918,9 @@ void MainWindow::setupTray()
     QMenu *menu = new QMenu(this);
     QAction *showAction = menu->addAction("Settings");
     connect(showAction, &QAction::triggered, this, &MainWindow::showMainWindow);
+
+    QAction *prefsAction = menu->addAction("Preferences...");
+    connect(prefsAction, &QAction::triggered, this, &MainWindow::showSettingsDialog);
     
     menu->addSeparator();
     
@@ -787,6 +943,22 @@ void MainWindow::setupTray()
     trayIcon->show();
 }
 
+void MainWindow::showSettingsDialog()
+{
+    SettingsDialog dialog(this);
+    connect(&dialog, &SettingsDialog::settingsSaved, this, [=](QString modelPath, int presetIndex) {
+        if (modelPath != DatabaseManager::instance().getSetting("model_path")) {
+            m_requestedModelPath = modelPath; // Saved once it has loaded
+            inference->loadModel(modelPath);
+        }
+        m_shortcut->setShortcut(static_cast<GlobalShortcut::Preset>(presetIndex));
+        audio->reloadSettings(); // Applies the pre-roll (arms or disarms the mic)
+        inference->reloadSettings();
+        m_transcriptionMode = DatabaseManager::instance().getSetting("transcription_mode", "batch");
+    });
+    dialog.exec();
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     // Instead of quitting, hide to tray
@@ -889,16 +1061,27 @@ void MainWindow::addHistoryItem(const QString &text, const QString &time, bool p
     historyContainer->updateGeometry();
 }
 
+void MainWindow::setModelStatus(const QString &text, const QString &color)
+{
+    m_modelStatus->setText(QString("● %1").arg(text));
+    m_modelStatus->setToolTip(QString());
+    m_modelStatus->setStyleSheet(QString("font-size: 11px; font-weight: 600; color: %1; background: #f4f4f5; border-radius: 10px; padding: 2px 8px;").arg(color));
+}
+
 void MainWindow::updateTranscription(QString text, bool isFinal)
 {
-    Q_UNUSED(isFinal); // we always show live updates on label
-    if (text.isEmpty()) return;
-    
-    liveLabel->setText(text);
-    // Compact pill overlay doesn't show text
-    
+    if (!isRecording) return; // Late partial from a take that already ended
+
+    // Committed segments accumulate; the unstable tail is replaced each time
     if (isFinal) {
-        // If ever we want finalized entries in history, we'd add them here
-        // For now, we manually add on Stop Recording
+        if (text.isEmpty()) return;
+        m_liveCommitted += (m_liveCommitted.isEmpty() ? "" : " ") + text;
+    } else {
+        m_livePartial = text;
     }
+    if (m_liveCommitted.isEmpty() && m_livePartial.isEmpty()) return;
+
+    // Compact pill overlay doesn't show text
+    liveLabel->setText(m_liveCommitted.toHtmlEscaped()
+                       + " <span style='color: #a1a1aa;'>" + m_livePartial.toHtmlEscaped() + "</span>");
 }
@@ -0,0 +1,284 @@
+#include "modelcatalog.h"
+#include "cputopology.h"
+#include "databasemanager.h"
+#include "inferenceworker.h"
+#include "modelfile.h"
+#include "wavfile.h"
+#include "whisperstatepool.h"
+#include "whisper.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <cstring>
+
+static const quint32 kGgmlMagic = 0x67676d6c; // "ggml"
+static const int kQuantVersionFactor = 1000;  // ftype carries the quantization version in its thousands
+static const int kSampleRate = 16000;
+
+// whisper.cpp's samples/jfk.wav, installed with the app
+static const char *kReferenceFile = "jfk.wav";
+static const char *kReferenceText = "And so my fellow Americans, ask not what your country can do for you, "
+                                    "ask what you can do for your country.";
+
+static QString ftypeName(int ftype)
+{
+    switch (ftype % kQuantVersionFactor) {
+    case 0: return "f32";
+    case 1: return "f16";
+    case 2: return "q4_0";
+    case 3: return "q4_1";
+    case 7: return "q8_0";
+    case 8: return "q5_0";
+    case 9: return "q5_1";
+    case 10: return "q2_k";
+    case 11: return "q3_k";
+    case 12: return "q4_k";
+    case 13: return "q5_k";
+    case 14: return "q6_k";
+    default: return QString("ftype %1").arg(ftype);
+    }
+}
+
+// Layer counts and vocabulary size identify the release
+static QString familyName(int vocab, int audioLayers, int textLayers)
+{
+    QString name;
+    switch (audioLayers) {
+    case 4: name = "tiny"; break;
+    case 6: name = "base"; break;
+    case 12: name = "small"; break;
+    case 24: name = "medium"; break;
+    case 32: name = vocab >= 51866 ? (textLayers == 4 ? "large-v3-turbo" : "large-v3") : "large"; break;
+    default: name = QString("%1-layer").arg(audioLayers); break;
+    }
+    if (vocab == 51864) name += ".en"; // English-only vocabulary
+    return name;
+}
+
+QString ModelCatalog::Entry::label() const
+{
+    QString text = QString("%1 %2, %3 MB").arg(family, quantization).arg(bytes / (1024 * 1024));
+    if (isMeasured()) {
+        text += QString(", %1x real time, %2% accurate").arg(rtf, 0, 'f', 2).arg(accuracy, 0, 'f', 0);
+    }
+    return text;
+}
+
+QStringList ModelCatalog::searchDirs()
+{
+    return {
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/models", // Wizard downloads
+        QCoreApplication::applicationDirPath() + "/models",
+        QCoreApplication::applicationDirPath() + "/../share/toice/assets/models",
+        "/app/share/toice/assets/models", // Flatpak bundle
+    };
+}
+
+bool ModelCatalog::readHeader(const QString &path, Entry &entry)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    // Magic, then n_vocab, n_audio_ctx, n_audio_state, n_audio_head, n_audio_layer,
+    // n_text_ctx, n_text_state, n_text_head, n_text_layer, n_mels, ftype
+    const QByteArray header = file.read(12 * 4);
+    if (header.size() < 12 * 4) return false;
+    qint32 fields[12];
+    memcpy(fields, header.constData(), sizeof(fields));
+    if (quint32(fields[0]) != kGgmlMagic) return false;
+
+    const QFileInfo info(path);
+    entry.path = info.canonicalFilePath();
+    entry.family = familyName(fields[1], fields[5], fields[9]);
+    entry.quantization = ftypeName(fields[11]);
+    entry.bytes = info.size();
+    entry.modified = info.lastModified();
+    return true;
+}
+
+// Measurements are keyed by path and only trusted while size and mtime match
+static QJsonObject savedMeasurements()
+{
+    return QJsonDocument::fromJson(DatabaseManager::instance().getSetting("model_benchmarks").toUtf8()).object();
+}
+
+QVector<ModelCatalog::Entry> ModelCatalog::discover()
+{
+    const QJsonObject saved = savedMeasurements();
+    QVector<Entry> entries;
+    QStringList seen;
+    for (const QString &dir : searchDirs()) {
+        for (const QFileInfo &info : QDir(dir).entryInfoList({"*.bin"}, QDir::Files, QDir::Name)) {
+            Entry entry;
+            if (seen.contains(info.canonicalFilePath()) || !readHeader(info.filePath(), entry)) continue;
+            seen << entry.path;
+
+            const QJsonObject measured = saved.value(entry.path).toObject();
+            if (measured.value("bytes").toVariant().toLongLong() == entry.bytes
+                && measured.value("modified").toVariant().toLongLong() == entry.modified.toSecsSinceEpoch()) {
+                entry.rtf = measured.value("rtf").toDouble(-1.0);
+                entry.accuracy = measured.value("accuracy").toDouble(-1.0);
+            }
+            entries.append(entry);
+        }
+    }
+    return entries;
+}
+
+void ModelCatalog::saveMeasurement(const Entry &entry)
+{
+    QJsonObject saved = savedMeasurements();
+    QJsonObject measured;
+    measured.insert("bytes", QString::number(entry.bytes));
+    measured.insert("modified", QString::number(entry.modified.toSecsSinceEpoch()));
+    measured.insert("rtf", entry.rtf);
+    measured.insert("accuracy", entry.accuracy);
+    saved.insert(entry.path, measured);
+    DatabaseManager::instance().setSetting("model_benchmarks", QString::fromUtf8(QJsonDocument(saved).toJson(QJsonDocument::Compact)));
+}
+
+int ModelCatalog::recommend(const QVector<Entry> &entries, double accuracyFloor)
+{
+    int best = -1;
+    for (int i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        if (!entry.isMeasured() || entry.accuracy < accuracyFloor) continue;
+        if (best < 0 || entry.rtf < entries.at(best).rtf) best = i;
+    }
+    return best;
+}
+
+ModelCatalog::Reference ModelCatalog::referenceClip()
+{
+    Reference reference;
+    const QStringList candidates = {
+        QCoreApplication::applicationDirPath() + "/reference/",        // Build tree
+        QCoreApplication::applicationDirPath() + "/../share/toice/reference/",
+        "/app/share/toice/reference/",
+    };
+    for (const QString &dir : candidates) {
+        if (WavFile::load(dir + kReferenceFile, reference.pcm) && !reference.pcm.isEmpty()) {
+            reference.text = kReferenceText;
+            break;
+        }
+    }
+    return reference;
+}
+
+static QStringList normalizedWords(const QString &text)
+{
+    static const QRegularExpression nonWord("[^a-z0-9' ]");
+    return text.toLower().replace(nonWord, " ").split(' ', Qt::SkipEmptyParts);
+}
+
+// 100 - word error rate (word-level edit distance over the reference length)
+double ModelCatalog::wordAccuracy(const QString &reference, const QString &hypothesis)
+{
+    const QStringList ref = normalizedWords(reference);
+    const QStringList hyp = normalizedWords(hypothesis);
+    if (ref.isEmpty()) return hyp.isEmpty() ? 100.0 : 0.0;
+
+    QVector<int> previous(hyp.size() + 1), current(hyp.size() + 1);
+    for (int j = 0; j <= hyp.size(); ++j) previous[j] = j;
+    for (int i = 1; i <= ref.size(); ++i) {
+        current[0] = i;
+        for (int j = 1; j <= hyp.size(); ++j) {
+            const int substitution = previous[j - 1] + (ref.at(i - 1) == hyp.at(j - 1) ? 0 : 1);
+            current[j] = qMin(substitution, qMin(previous[j], current[j - 1]) + 1);
+        }
+        std::swap(previous, current);
+    }
+    return qMax(0.0, 100.0 * (1.0 - double(previous[hyp.size()]) / ref.size()));
+}
+
+bool ModelCatalog::measure(Entry &entry, const Reference &reference, const DecodingPolicy &policy, int threads,
+                           const std::atomic<bool> *cancel)
+{
+    if (!reference.isValid()) return false;
+    ModelFile file;
+    if (!file.open(entry.path, true)) return false;
+    file.prefault();
+    file.setCancel(cancel);
+    const std::shared_ptr<WhisperStatePool> pool = WhisperStatePool::load(file, 1);
+    if (!pool) return false;
+    WhisperStatePool::Lease lease = pool->acquire();
+
+    whisper_full_params wparams = policy.params(threads);
+    wparams.abort_callback = [](void *userData) {
+        auto *cancel = static_cast<const std::atomic<bool>*>(userData);
+        return cancel && cancel->load(std::memory_order_relaxed);
+    };
+    wparams.abort_callback_user_data = const_cast<std::atomic<bool>*>(cancel);
+
+    const int samples = int(reference.pcm.size());
+    DecodingPolicy::Result warmUp, result;
+    bool ok = policy.decode(pool->context(), lease.state(), wparams, reference.pcm.constData(), samples, warmUp); // Page in weights, size buffers
+    ok = ok && policy.decode(pool->context(), lease.state(), wparams, reference.pcm.constData(), samples, result);
+
+    if (ok) {
+        entry.rtf = double(result.ms) / (1000.0 * samples / kSampleRate);
+        entry.accuracy = wordAccuracy(reference.text, result.text);
+    }
+    return ok;
+}
+
+QString ModelCatalog::quantizeTool()
+{
+    // Next to the app first (bundled builds), then PATH
+    const QStringList appDir = {QCoreApplication::applicationDirPath()};
+    for (const QString &name : {QString("whisper-quantize"), QString("quantize")}) {
+        const QString tool = QStandardPaths::findExecutable(name, appDir);
+        if (!tool.isEmpty()) return tool;
+    }
+    return QStandardPaths::findExecutable("whisper-quantize");
+}
+
+// ggml-base.en.bin -> ggml-base.en-q5_0.bin in the downloads folder, where
+// discover() finds it (the source may sit in a read-only or custom location)
+QString ModelCatalog::quantizedPath(const QString &source, const QString &type)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/models";
+    QDir().mkpath(dir);
+    return dir + "/" + QFileInfo(source).completeBaseName() + "-" + type + ".bin";
+}
+
+int ModelCatalog::runBenchmark(double accuracyFloor)
+{
+    QTextStream out(stdout);
+    if (!DatabaseManager::instance().init()) return 1;
+    CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+
+    const Reference reference = referenceClip();
+    if (!reference.isValid()) {
+        out << "Reference clip " << kReferenceFile << " not found\n";
+        return 1;
+    }
+    QVector<Entry> entries = discover();
+    if (entries.isEmpty()) {
+        out << "No models found in " << searchDirs().join(", ") << "\n";
+        return 1;
+    }
+
+    const int threads = InferenceWorker::configuredThreads();
+    const DecodingPolicy policy = DecodingPolicy::fromSettings();
+    out << "Models on the reference clip (" << reference.pcm.size() / kSampleRate << " s, " << threads << " threads)\n";
+    for (Entry &entry : entries) {
+        if (!measure(entry, reference, policy, threads, nullptr)) {
+            out << "  " << entry.path << ": failed\n";
+            continue;
+        }
+        saveMeasurement(entry);
+        out << "  " << entry.label() << "\n      " << entry.path << "\n";
+        out.flush();
+    }
+
+    const int best = recommend(entries, accuracyFloor);
+    if (best < 0) out << "\nNo model reaches " << accuracyFloor << "% accuracy\n";
+    else out << "\nRecommended (fastest at >= " << accuracyFloor << "% accuracy): " << entries.at(best).label() << "\n";
+    return 0;
+}
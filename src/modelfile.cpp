@@ -0,0 +1,125 @@
+#include "modelfile.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const qint64 kReleaseChunk = 32 * 1024 * 1024; // Drop consumed pages in 32 MB steps
+
+ModelFile::~ModelFile()
+{
+    close();
+}
+
+bool ModelFile::open(const QString &path, bool mapped)
+{
+    close();
+    m_pos = 0;
+    m_released = 0;
+    m_percent = -1;
+    if (path.isEmpty()) return false;
+
+    if (mapped) {
+        m_fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (m_fd >= 0 && fstat(m_fd, &st) == 0 && st.st_size > 0) {
+            void *address = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, m_fd, 0);
+            if (address != MAP_FAILED) {
+                m_map = static_cast<uchar*>(address);
+                m_size = st.st_size;
+                madvise(m_map, size_t(m_size), MADV_SEQUENTIAL);
+                return true;
+            }
+            qWarning() << "Could not map model" << path << strerror(errno) << "- reading it instead";
+        }
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    m_size = m_file.size();
+    return true;
+}
+
+void ModelFile::prefault()
+{
+    if (m_map) {
+        madvise(m_map, size_t(m_size), MADV_WILLNEED); // Asynchronous readahead
+    } else if (m_file.isOpen()) {
+        posix_fadvise(m_file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+    }
+}
+
+whisper_model_loader ModelFile::loader()
+{
+    whisper_model_loader loader = {};
+    loader.context = this;
+    loader.read = [](void *context, void *output, size_t bytes) -> size_t {
+        return static_cast<ModelFile*>(context)->read(output, bytes);
+    };
+    loader.eof = [](void *context) -> bool {
+        auto *file = static_cast<ModelFile*>(context);
+        return file->m_pos >= file->m_size;
+    };
+    loader.close = [](void *context) {
+        static_cast<ModelFile*>(context)->close();
+    };
+    return loader;
+}
+
+size_t ModelFile::read(void *output, size_t bytes)
+{
+    if (m_cancel && m_cancel->load(std::memory_order_relaxed)) return 0; // Shutting down: fail fast
+
+    qint64 got = 0;
+    if (m_map) {
+        got = qMin(qint64(bytes), m_size - m_pos);
+        memcpy(output, m_map + m_pos, size_t(got));
+        m_pos += got;
+
+        // ggml keeps its own copy of every tensor, so what we've read is only
+        // page cache now; stop counting it against this process
+        if (m_pos - m_released >= kReleaseChunk) {
+            const qint64 end = m_pos & ~qint64(getpagesize() - 1);
+            madvise(m_map + m_released, size_t(end - m_released), MADV_DONTNEED);
+            m_released = end;
+        }
+    } else {
+        got = qMax<qint64>(0, m_file.read(static_cast<char*>(output), qint64(bytes)));
+        m_pos += got;
+    }
+
+    const int percent = int(m_pos * 100 / qMax<qint64>(1, m_size));
+    if (percent != m_percent && m_progress) {
+        m_percent = percent;
+        m_progress(percent);
+    }
+    return size_t(got);
+}
+
+void ModelFile::close()
+{
+    if (m_map) {
+        munmap(m_map, size_t(m_size));
+        m_map = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_file.close();
+}
+
+qint64 ModelFile::residentKb()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) return 0;
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:")) return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+    return 0;
+}
@@ -22,6 +22,7 @@ OverlayWidget::OverlayWidget(QWidget *parent) : QWidget(parent) {
     for(int i=0; i<6; ++i) {
         m_barHeights[i] = 4.0f;
         m_barPhases[i] = (float)i * 1.5f;
+        m_bandLevels[i] = 0.0f;
     }
     
     pulseTimer = new QTimer(this);
@@ -125,21 +126,29 @@ void OverlayWidget::showSuccessMessage(const QString &msg) {
     doTransition();
 }
 
-void OverlayWidget::setAudioLevel(float level) {
+// Called once per display frame with the latest meter snapshot; the pulse
+// timer does the repaint, so no update() here.
+void OverlayWidget::setMeter(const MeterSnapshot &meter) {
     if (m_state != Recording) return;
+    for (int i = 0; i < 6; i++) {
+        // Fast attack, slower release so bars don't flicker between frames
+        float v = meter.bands[i];
+        m_bandLevels[i] = (v > m_bandLevels[i]) ? v : m_bandLevels[i] * 0.85f + v * 0.15f;
+    }
+    m_hasBands = meter.hasBands;
+
     float alpha = 0.2f;
-    currentLevel = currentLevel * (1.0f - alpha) + level * alpha;
+    currentLevel = currentLevel * (1.0f - alpha) + meter.peak * alpha;
     for (int i = 0; i < 6; i++) {
         m_barPhases[i] += 0.1f + (float)i * 0.02f;
         float oscillation = 0.8f + std::sin(m_barPhases[i]) * 0.4f;
-        float target = 4.0f + (std::sqrt(currentLevel) * 35.0f * oscillation);
+        // Drive each bar from its spectrum band once we have one, else from overall level
+        float drive = m_hasBands ? m_bandLevels[i] : std::sqrt(currentLevel);
+        float target = 4.0f + (drive * 35.0f * oscillation);
         m_barHeights[i] = m_barHeights[i] * 0.6f + target * 0.4f;
     }
-    update();
 }
 
-void OverlayWidget::setFrequencyBands(const QVector<float> &bands) { Q_UNUSED(bands); }
-
 void OverlayWidget::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
     QPainter painter(this);
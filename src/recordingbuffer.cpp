@@ -0,0 +1,94 @@
+#include "recordingbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+// ---------------- RecordingView ----------------
+
+void RecordingView::appendSpan(const Span &span)
+{
+    if (span.length <= 0) return;
+    m_spans.append(span);
+    m_size += span.length;
+}
+
+RecordingView RecordingView::mid(qint64 start, qint64 length) const
+{
+    RecordingView result;
+    start = qBound<qint64>(0, start, m_size);
+    if (length < 0 || start + length > m_size) length = m_size - start;
+    if (length <= 0) return result;
+
+    qint64 spanStart = 0;
+    const qint64 end = start + length;
+    for (const Span &span : m_spans) {
+        const qint64 spanEnd = spanStart + span.length;
+        if (spanEnd > start && spanStart < end) {
+            const qint64 from = qMax(start, spanStart) - spanStart;
+            const qint64 to = qMin(end, spanEnd) - spanStart;
+            result.appendSpan({span.owner, span.data + from, to - from});
+        }
+        if (spanEnd >= end) break;
+        spanStart = spanEnd;
+    }
+    return result;
+}
+
+const float *RecordingView::contiguousData() const
+{
+    return m_spans.size() == 1 ? m_spans.first().data : nullptr;
+}
+
+void RecordingView::copyTo(float *dest) const
+{
+    for (const Span &span : m_spans) {
+        std::memcpy(dest, span.data, span.length * sizeof(float));
+        dest += span.length;
+    }
+}
+
+// ---------------- RecordingBuffer ----------------
+
+void RecordingBuffer::append(const float *data, qint64 count)
+{
+    QMutexLocker locker(&m_mutex);
+    while (count > 0) {
+        if (m_tailFill == kBlockSamples) {
+            // One allocation per block (~1 s of audio), never per callback
+            m_blocks.append(std::shared_ptr<Block>(new Block)); // Left uninitialised on purpose
+            m_tailFill = 0;
+        }
+        const int toCopy = int(qMin<qint64>(count, kBlockSamples - m_tailFill));
+        std::memcpy(m_blocks.last()->samples + m_tailFill, data, toCopy * sizeof(float));
+        m_tailFill += toCopy;
+        m_size += toCopy;
+        data += toCopy;
+        count -= toCopy;
+    }
+}
+
+void RecordingBuffer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    // Outstanding views keep their blocks alive; we just start a fresh chain
+    m_blocks.clear();
+    m_tailFill = kBlockSamples;
+    m_size = 0;
+}
+
+RecordingView RecordingBuffer::view() const
+{
+    QMutexLocker locker(&m_mutex);
+    RecordingView result;
+    for (int i = 0; i < m_blocks.size(); ++i) {
+        const qint64 length = (i == m_blocks.size() - 1) ? m_tailFill : kBlockSamples;
+        const std::shared_ptr<Block> &block = m_blocks[i];
+        result.appendSpan({block, block->samples, length});
+    }
+    return result;
+}
+
+qint64 RecordingBuffer::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
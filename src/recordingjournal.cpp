@@ -0,0 +1,275 @@
+#include "recordingjournal.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'T', 'O', 'I', 'C', 'E', 'J', 'N', 'L'};
+static const quint32 kVersion = 1;
+static const qint64 kHeaderBytes = 4096;                 // One page, so samples are page-aligned
+static const qint64 kAllocChunkSamples = 2 * 1024 * 1024; // Disk reserved ahead of the writer (8 MB)
+static const qint64 kWritebackSamples = 64 * 1024;        // Start writeback every 256 KB
+static const int kHotWindowSeconds = 30;                  // Newest audio kept resident
+
+// Set once fallocate turns out to be unsupported here: writes into a sparse
+// mapping would SIGBUS on a full disk, so takes stay in RAM instead
+static std::atomic<bool> s_cannotPreallocate{false};
+
+struct RecordingJournal::Header {
+    char magic[8];
+    quint32 version;
+    quint32 sampleRate;
+    std::atomic<quint32> state;
+    quint32 reserved;
+    qint64 startedAtMs;
+    std::atomic<qint64> samples; // Committed sample count
+};
+static_assert(std::atomic<qint64>::is_always_lock_free, "The journal header is shared through a file mapping");
+
+struct RecordingJournal::Mapping {
+    int fd = -1;
+    void *address = MAP_FAILED;
+    size_t length = 0;
+
+    ~Mapping()
+    {
+        if (address != MAP_FAILED) munmap(address, length);
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+RecordingJournal::~RecordingJournal() = default;
+
+QString RecordingJournal::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal";
+}
+
+std::shared_ptr<RecordingJournal> RecordingJournal::create(const QString &directory, int sampleRate)
+{
+    if (s_cannotPreallocate) return nullptr;
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "Could not create journal directory" << directory;
+        return nullptr;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QString path = QDir(directory).filePath(QString("take-%1.journal").arg(now));
+    const QByteArray nativePath = QFile::encodeName(path);
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->fd = ::open(nativePath.constData(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (mapping->fd < 0) {
+        qWarning() << "Could not create recording journal" << path << strerror(errno);
+        return nullptr;
+    }
+    // Held while the file is open, so pending() leaves journals that are still in use alone
+    flock(mapping->fd, LOCK_EX | LOCK_NB);
+
+    // Sparse reservation of the whole address range; disk blocks are allocated
+    // ahead of the writer in append(), so the mapping never has to move.
+    const qint64 capacity = qint64(kMaxSeconds) * sampleRate;
+    mapping->length = size_t(kHeaderBytes + capacity * qint64(sizeof(float)));
+    bool ok = ftruncate(mapping->fd, off_t(mapping->length)) == 0;
+    if (ok && fallocate(mapping->fd, 0, 0, kHeaderBytes) != 0) {
+        if (errno == EOPNOTSUPP) {
+            qWarning() << "The journal's file system can't preallocate; recordings stay in memory";
+            s_cannotPreallocate = true;
+        }
+        ok = false;
+    }
+    if (ok) {
+        mapping->address = mmap(nullptr, mapping->length, PROT_READ | PROT_WRITE, MAP_SHARED, mapping->fd, 0);
+        ok = mapping->address != MAP_FAILED;
+    }
+    if (!ok) {
+        qWarning() << "Could not map recording journal" << path << strerror(errno);
+        unlink(nativePath.constData());
+        return nullptr;
+    }
+    madvise(mapping->address, mapping->length, MADV_SEQUENTIAL);
+
+    std::shared_ptr<RecordingJournal> journal(new RecordingJournal());
+    journal->m_path = path;
+    journal->m_mapping = mapping;
+    journal->m_header = new (mapping->address) Header;
+    memcpy(journal->m_header->magic, kMagic, sizeof(kMagic));
+    journal->m_header->version = kVersion;
+    journal->m_header->sampleRate = quint32(sampleRate);
+    journal->m_header->state.store(Recording);
+    journal->m_header->reserved = 0;
+    journal->m_header->startedAtMs = now;
+    journal->m_header->samples.store(0);
+    journal->m_samples = reinterpret_cast<float*>(static_cast<char*>(mapping->address) + kHeaderBytes);
+    journal->m_capacity = capacity;
+    return journal;
+}
+
+std::shared_ptr<RecordingJournal> RecordingJournal::open(const QString &path)
+{
+    auto mapping = std::make_shared<Mapping>();
+    mapping->fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (mapping->fd < 0 || fstat(mapping->fd, &st) != 0 || st.st_size < kHeaderBytes) {
+        qWarning() << "Could not open recording journal" << path;
+        return nullptr;
+    }
+
+    mapping->length = size_t(st.st_size);
+    mapping->address = mmap(nullptr, mapping->length, PROT_READ, MAP_SHARED, mapping->fd, 0);
+    if (mapping->address == MAP_FAILED) {
+        qWarning() << "Could not map recording journal" << path << strerror(errno);
+        return nullptr;
+    }
+
+    Header *header = static_cast<Header*>(mapping->address);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion || header->sampleRate == 0) {
+        qWarning() << "Not a recording journal:" << path;
+        return nullptr;
+    }
+
+    std::shared_ptr<RecordingJournal> journal(new RecordingJournal());
+    journal->m_path = path;
+    journal->m_mapping = mapping;
+    journal->m_header = header;
+    journal->m_samples = reinterpret_cast<float*>(static_cast<char*>(mapping->address) + kHeaderBytes);
+    // Trust the header, but never past what actually reached the file
+    journal->m_capacity = (st.st_size - kHeaderBytes) / qint64(sizeof(float));
+    journal->m_written = qBound<qint64>(0, header->samples.load(), journal->m_capacity);
+    journal->m_readOnly = true;
+    return journal;
+}
+
+// The writer holds an exclusive flock for as long as it has the file open;
+// a crashed writer's lock went away with it
+bool RecordingJournal::isInUse(const QString &path)
+{
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool locked = flock(fd, LOCK_SH | LOCK_NB) != 0 && errno == EWOULDBLOCK;
+    ::close(fd);
+    return locked;
+}
+
+QStringList RecordingJournal::pending(const QString &directory)
+{
+    QStringList result;
+    const QDir dir(directory);
+    const QStringList names = dir.entryList({"take-*.journal"}, QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QString &name : names) {
+        const QString path = dir.filePath(name);
+        if (isInUse(path)) continue; // This process's spare or current take
+        std::shared_ptr<RecordingJournal> journal = open(path);
+        if (!journal || journal->m_header->state.load() == Transcribed || journal->size() == 0) {
+            QFile::remove(path); // Nothing worth recovering
+            continue;
+        }
+        result.append(path);
+    }
+    return result;
+}
+
+bool RecordingJournal::append(const float *samples, qint64 count)
+{
+    if (m_failed || m_readOnly) return false;
+    if (m_written + count > m_capacity) {
+        qWarning() << "Recording journal is full after" << kMaxSeconds << "seconds";
+        m_failed = true;
+        return false;
+    }
+
+    // Allocate disk ahead of the writer, so a full disk shows up here instead
+    // of as a SIGBUS inside memcpy
+    if (m_written + count > m_allocated) {
+        const qint64 chunk = qMin(qMax(kAllocChunkSamples, m_written + count - m_allocated), m_capacity - m_allocated);
+        const off_t offset = off_t(kHeaderBytes + m_allocated * qint64(sizeof(float)));
+        if (fallocate(m_mapping->fd, 0, offset, off_t(chunk * qint64(sizeof(float)))) != 0) {
+            qWarning() << "Recording journal could not grow:" << strerror(errno);
+            m_failed = true;
+            return false;
+        }
+        m_allocated += chunk;
+    }
+
+    memcpy(m_samples + m_written, samples, size_t(count) * sizeof(float));
+    m_written += count;
+    m_header->samples.store(m_written, std::memory_order_release);
+
+    if (m_written - m_flushed >= kWritebackSamples) writeBack();
+    return true;
+}
+
+// Start writeback of the new range (sequential, asynchronous) and drop pages
+// that fell out of the hot window from our resident set. They stay in the
+// file and fault back in from the page cache or disk if a view reads them.
+void RecordingJournal::writeBack()
+{
+    const qint64 samplesPerPage = sysconf(_SC_PAGESIZE) / qint64(sizeof(float));
+    const qint64 from = (m_flushed / samplesPerPage) * samplesPerPage;
+    sync_file_range(m_mapping->fd, off_t(kHeaderBytes + from * qint64(sizeof(float))),
+                    off_t((m_written - from) * qint64(sizeof(float))), SYNC_FILE_RANGE_WRITE);
+    m_flushed = m_written;
+
+    const qint64 hot = qint64(kHotWindowSeconds) * m_header->sampleRate;
+    const qint64 evictTo = ((m_written - hot) / samplesPerPage) * samplesPerPage;
+    if (evictTo > m_evicted) {
+        const qint64 bytes = (evictTo - m_evicted) * qint64(sizeof(float));
+        madvise(m_samples + m_evicted, size_t(bytes), MADV_DONTNEED);
+        // Written back long ago by now, so the page cache can let go too
+        posix_fadvise(m_mapping->fd, off_t(kHeaderBytes + m_evicted * qint64(sizeof(float))), off_t(bytes),
+                      POSIX_FADV_DONTNEED);
+        m_evicted = evictTo;
+    }
+}
+
+void RecordingJournal::finish()
+{
+    if (m_readOnly || !m_header) return;
+    writeBack();
+    m_header->state.store(Finished, std::memory_order_release);
+
+    // Give back the disk reserved ahead of the writer; nothing maps past m_written
+    if (ftruncate(m_mapping->fd, off_t(kHeaderBytes + m_written * qint64(sizeof(float)))) == 0) {
+        m_capacity = m_allocated = m_written;
+    }
+    sync_file_range(m_mapping->fd, 0, kHeaderBytes, SYNC_FILE_RANGE_WRITE);
+}
+
+void RecordingJournal::markTranscribed()
+{
+    if (!m_readOnly && m_header) m_header->state.store(Transcribed, std::memory_order_release);
+    QFile::remove(m_path); // Open views keep their mapping
+}
+
+RecordingView RecordingJournal::view() const
+{
+    RecordingView view;
+    const qint64 count = size();
+    if (count > 0) view.appendSpan({m_mapping, m_samples, count});
+    return view;
+}
+
+qint64 RecordingJournal::size() const
+{
+    if (!m_header) return 0;
+    return m_readOnly ? m_written : m_header->samples.load(std::memory_order_acquire);
+}
+
+int RecordingJournal::sampleRate() const
+{
+    return m_header ? int(m_header->sampleRate) : 0;
+}
+
+qint64 RecordingJournal::startedAtMs() const
+{
+    return m_header ? m_header->startedAtMs : 0;
+}
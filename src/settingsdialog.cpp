@@ -1,16 +1,24 @@
 #include "settingsdialog.h"
 #include "databasemanager.h"
 #include "globalshortcut.h"
+#include "threadcalibrator.h"
+#include "cputopology.h"
+#include "inferenceworker.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
+#include <QCheckBox>
 #include <QFileDialog>
 #include <QCoreApplication>
+#include <QThread>
+#include <QFileInfo>
+#include <QSignalBlocker>
+#include <algorithm>
 
 SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
 {
     setWindowTitle("Settings");
-    setFixedSize(500, 350);
+    setFixedSize(500, 920);
     setStyleSheet("background: white; font-family: 'Inter', sans-serif;");
 
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
@@ -22,9 +30,8 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     grpModel->setStyleSheet("QGroupBox { border: 1px solid #e4e4e7; border-radius: 8px; margin-top: 10px; font-weight: 600; color: #18181b; } QGroupBox::title { subcontrol-origin: margin; left: 10px; padding: 0 5px; }");
     QVBoxLayout *modelLayout = new QVBoxLayout(grpModel);
     
+    // Filled by refreshModels(): the default, every model found on disk, and a custom path
     comboModel = new QComboBox();
-    comboModel->addItem("Default (Small English)", "default");
-    comboModel->addItem("Custom Path...", "custom");
     comboModel->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
     
     lblModelPath = new QLabel("Path: Built-in");
@@ -35,9 +42,33 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     btnBrowse->setCursor(Qt::PointingHandCursor);
     btnBrowse->setEnabled(false); // Default disabled
     
+    // Quantized models: measure speed and accuracy on the reference clip, and
+    // pick the fastest one that stays above the floor
+    btnMeasure = new QPushButton("Measure Models");
+    btnMeasure->setCursor(Qt::PointingHandCursor);
+    btnQuantize = new QPushButton("Quantize to q5_0");
+    btnQuantize->setCursor(Qt::PointingHandCursor);
+    QHBoxLayout *catalogRow = new QHBoxLayout();
+    catalogRow->addWidget(btnMeasure);
+    catalogRow->addWidget(btnQuantize);
+
+    comboFloor = new QComboBox();
+    for (int floor : {80, 85, 90, 95, 98}) comboFloor->addItem(QString("Accuracy floor: %1%").arg(floor), floor);
+    comboFloor->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+
+    lblRecommendation = new QLabel();
+    lblRecommendation->setStyleSheet("color: #71717a; font-size: 11px;");
+    lblRecommendation->setWordWrap(true);
+    btnUseRecommended = new QPushButton("Use Recommended");
+    btnUseRecommended->setCursor(Qt::PointingHandCursor);
+
     modelLayout->addWidget(comboModel);
     modelLayout->addWidget(btnBrowse);
     modelLayout->addWidget(lblModelPath);
+    modelLayout->addLayout(catalogRow);
+    modelLayout->addWidget(comboFloor);
+    modelLayout->addWidget(lblRecommendation);
+    modelLayout->addWidget(btnUseRecommended);
     
     mainLayout->addWidget(grpModel);
 
@@ -55,10 +86,92 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     
     shortLayout->addWidget(comboShortcut);
     mainLayout->addWidget(grpShortcut);
+
+    // --- 3. AUDIO ---
+    QGroupBox *grpAudio = new QGroupBox("Audio");
+    grpAudio->setStyleSheet("QGroupBox { border: 1px solid #e4e4e7; border-radius: 8px; margin-top: 10px; font-weight: 600; color: #18181b; } QGroupBox::title { subcontrol-origin: margin; left: 10px; padding: 0 5px; }");
+    QVBoxLayout *audioLayout = new QVBoxLayout(grpAudio);
+
+    comboPreroll = new QComboBox();
+    comboPreroll->addItem("Pre-roll: Off (mic only open while recording)", 0);
+    comboPreroll->addItem("Pre-roll: 300 ms", 300);
+    comboPreroll->addItem("Pre-roll: 500 ms", 500);
+    comboPreroll->addItem("Pre-roll: 1 s", 1000);
+    comboPreroll->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+
+    QLabel *lblPreroll = new QLabel("Keeps the microphone open so the first word before the shortcut isn't cut off.");
+    lblPreroll->setStyleSheet("color: #71717a; font-size: 11px;");
+    lblPreroll->setWordWrap(true);
+
+    checkDsp = new QCheckBox("Clean up audio (noise suppression, low-cut, auto gain)");
+    checkDsp->setStyleSheet("color: #18181b; font-weight: 400;");
+
+    audioLayout->addWidget(comboPreroll);
+    audioLayout->addWidget(lblPreroll);
+    audioLayout->addWidget(checkDsp);
+    mainLayout->addWidget(grpAudio);
+
+    // --- 4. TRANSCRIPTION ---
+    QGroupBox *grpTranscription = new QGroupBox("Transcription");
+    grpTranscription->setStyleSheet("QGroupBox { border: 1px solid #e4e4e7; border-radius: 8px; margin-top: 10px; font-weight: 600; color: #18181b; } QGroupBox::title { subcontrol-origin: margin; left: 10px; padding: 0 5px; }");
+    QVBoxLayout *transcriptionLayout = new QVBoxLayout(grpTranscription);
+
+    comboMode = new QComboBox();
+    comboMode->addItem("After recording (one pass when you stop)", "batch");
+    comboMode->addItem("Pipelined (pauses are transcribed while you speak; fastest result)", "pipelined");
+    comboMode->addItem("Live (text appears while you speak)", "streaming");
+    comboMode->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+
+    QLabel *lblMode = new QLabel("Live mode keeps the model busy while recording; on 4-core machines partial text updates less often.");
+    lblMode->setStyleSheet("color: #71717a; font-size: 11px;");
+    lblMode->setWordWrap(true);
+
+    // Thread count: calibrated per CPU and model unless pinned here
+    comboThreads = new QComboBox();
+    const bool calibratedHere = DatabaseManager::instance().getSetting("calibration_cpu") == ThreadCalibrator::cpuModel();
+    const int calibrated = calibratedHere ? DatabaseManager::instance().getSetting("calibrated_threads", "0").toInt() : 0;
+    comboThreads->addItem(calibrated > 0 ? QString("Threads: Auto (calibrated: %1)").arg(calibrated)
+                                         : QString("Threads: Auto (calibrates after the model loads)"), 0);
+    for (int threads : ThreadCalibrator::candidates(CpuTopology::instance().computeCpuCount())) {
+        comboThreads->addItem(QString("Threads: %1").arg(threads), threads);
+    }
+    comboThreads->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+
+    transcriptionLayout->addWidget(comboMode);
+    transcriptionLayout->addWidget(lblMode);
+    // Decoding policy: how hard to retry a doubtful segment, and for how long
+    comboDecoding = new QComboBox();
+    comboDecoding->addItem("Decoding: Fast (1 retry, 1 s budget)", "fast");
+    comboDecoding->addItem("Decoding: Balanced (2 retries, 2 s budget)", "balanced");
+    comboDecoding->addItem("Decoding: Accurate (beam search, no time limit)", "accurate");
+    comboDecoding->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+
+    transcriptionLayout->addWidget(comboThreads);
+    transcriptionLayout->addWidget(comboDecoding);
+
+    checkShortClips = new QCheckBox("Faster short dictations (encoder sized to the clip)");
+    checkShortClips->setStyleSheet("color: #18181b; font-weight: 400;");
+    checkShortClips->setToolTip("Clips under 10 s skip most of whisper's 30 s encoder window. "
+                                "Compare accuracy with --bench-audio-ctx.");
+    transcriptionLayout->addWidget(checkShortClips);
+
+    // Residency: the model is reloaded while recording, so unloading costs little
+    comboIdleUnload = new QComboBox();
+    comboIdleUnload->addItem("Unload model when idle: Never", 0);
+    comboIdleUnload->addItem("Unload model when idle: After 5 minutes", 5);
+    comboIdleUnload->addItem("Unload model when idle: After 15 minutes", 15);
+    comboIdleUnload->addItem("Unload model when idle: After 30 minutes", 30);
+    comboIdleUnload->addItem("Unload model when idle: After 1 hour", 60);
+    comboIdleUnload->addItem("Unload model when idle: After 2 hours", 120);
+    comboIdleUnload->setStyleSheet("padding: 8px; border: 1px solid #d4d4d8; border-radius: 4px;");
+    comboIdleUnload->setToolTip("Frees the model's memory; the next recording reloads it while you speak. "
+                                "It is also unloaded early when the system runs short of memory.");
+    transcriptionLayout->addWidget(comboIdleUnload);
+    mainLayout->addWidget(grpTranscription);
     
     mainLayout->addStretch();
 
-    // --- 3. BUTTONS ---
+    // --- 5. BUTTONS ---
     QHBoxLayout *btnLayout = new QHBoxLayout();
     btnLayout->addStretch();
     
@@ -71,10 +184,16 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     btnSave->setCursor(Qt::PointingHandCursor);
     btnSave->setStyleSheet("background: #18181b; color: white; border: none; padding: 8px 16px; border-radius: 6px;");
     connect(btnSave, &QPushButton::clicked, this, [=]() {
-        QString finalPath = (comboModel->currentData().toString() == "default") 
-                            ? QCoreApplication::applicationDirPath() + "/models/ggml-base.en.bin"
-                            : m_customModelPath;
-        
+        const QString finalPath = getSelectedModelPath();
+
+        DatabaseManager::instance().setSetting("model_accuracy_floor", comboFloor->currentData().toString());
+        DatabaseManager::instance().setSetting("preroll_ms", comboPreroll->currentData().toString());
+        DatabaseManager::instance().setSetting("dsp_enabled", checkDsp->isChecked() ? "1" : "0");
+        DatabaseManager::instance().setSetting("transcription_mode", comboMode->currentData().toString());
+        DatabaseManager::instance().setSetting("inference_threads", comboThreads->currentData().toString());
+        DatabaseManager::instance().setSetting("decode_preset", comboDecoding->currentData().toString());
+        DatabaseManager::instance().setSetting("dynamic_audio_ctx", checkShortClips->isChecked() ? "1" : "0");
+        DatabaseManager::instance().setSetting("model_idle_minutes", comboIdleUnload->currentData().toString());
         emit settingsSaved(finalPath, comboShortcut->currentData().toInt());
         accept();
     });
@@ -84,37 +203,212 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     mainLayout->addLayout(btnLayout);
     
     // --- LOGIC WIRING ---
-    connect(comboModel, &QComboBox::currentIndexChanged, this, [=](int index) {
-        bool isCustom = (comboModel->itemData(index).toString() == "custom");
-        btnBrowse->setEnabled(isCustom);
-        if (!isCustom) {
-            lblModelPath->setText("Path: Built-in Default");
-        } else {
-            lblModelPath->setText(m_customModelPath.isEmpty() ? "Path: None selected" : m_customModelPath);
-        }
-    });
+    connect(comboModel, &QComboBox::currentIndexChanged, this, &SettingsDialog::updateModelControls);
+    connect(comboFloor, &QComboBox::currentIndexChanged, this, &SettingsDialog::updateModelControls);
     
     connect(btnBrowse, &QPushButton::clicked, this, [=]() {
         QString path = QFileDialog::getOpenFileName(this, "Select Model File", "", "Model Files (*.bin)");
         if (!path.isEmpty()) {
             m_customModelPath = path;
-            lblModelPath->setText(path);
+            updateModelControls();
         }
     });
+
+    connect(btnMeasure, &QPushButton::clicked, this, &SettingsDialog::startMeasuring);
+    connect(btnQuantize, &QPushButton::clicked, this, &SettingsDialog::startQuantizing);
+    connect(btnUseRecommended, &QPushButton::clicked, this, [=]() {
+        if (m_recommended >= 0) comboModel->setCurrentIndex(comboModel->findData(m_models.at(m_recommended).path));
+    });
     
     // --- LOAD CURRENT SETTINGS ---
+    int idx = -1;
     QString currentModel = DatabaseManager::instance().getSetting("model_path");
     QString defaultModel = QCoreApplication::applicationDirPath() + "/models/ggml-base.en.bin";
     
+    idx = comboFloor->findData(DatabaseManager::instance().getSetting("model_accuracy_floor", "90").toInt());
+    if (idx >= 0) comboFloor->setCurrentIndex(idx);
+
     if (currentModel.isEmpty() || currentModel == defaultModel) {
-        comboModel->setCurrentIndex(0);
+        refreshModels("default");
     } else {
-        comboModel->setCurrentIndex(1);
-        m_customModelPath = currentModel;
-        lblModelPath->setText(currentModel);
+        const QString canonical = QFileInfo(currentModel).canonicalFilePath();
+        refreshModels(canonical);
+        if (comboModel->currentData().toString() != canonical) { // Not in a models folder
+            m_customModelPath = currentModel;
+            comboModel->setCurrentIndex(comboModel->findData("custom"));
+        }
     }
     
     int currentPreset = DatabaseManager::instance().getSetting("shortcut_preset", "0").toInt(); // 0 = SuperZ
-    int idx = comboShortcut->findData(currentPreset);
+    idx = comboShortcut->findData(currentPreset);
     if (idx >= 0) comboShortcut->setCurrentIndex(idx);
+
+    int currentPreroll = DatabaseManager::instance().getSetting("preroll_ms", "0").toInt();
+    idx = comboPreroll->findData(currentPreroll);
+    if (idx >= 0) comboPreroll->setCurrentIndex(idx);
+
+    checkDsp->setChecked(DatabaseManager::instance().getSetting("dsp_enabled", "0") == "1");
+
+    idx = comboMode->findData(DatabaseManager::instance().getSetting("transcription_mode", "batch"));
+    if (idx >= 0) comboMode->setCurrentIndex(idx);
+
+    idx = comboThreads->findData(DatabaseManager::instance().getSetting("inference_threads", "0").toInt());
+    if (idx >= 0) comboThreads->setCurrentIndex(idx);
+
+    idx = comboDecoding->findData(DatabaseManager::instance().getSetting("decode_preset", "balanced"));
+    if (idx >= 0) comboDecoding->setCurrentIndex(idx);
+
+    checkShortClips->setChecked(DatabaseManager::instance().getSetting("dynamic_audio_ctx", "0") == "1");
+
+    idx = comboIdleUnload->findData(DatabaseManager::instance().getSetting("model_idle_minutes", "30").toInt());
+    if (idx >= 0) comboIdleUnload->setCurrentIndex(idx);
+}
+
+SettingsDialog::~SettingsDialog()
+{
+    if (m_measureThread) {
+        m_cancelMeasure = true; // Aborts the decode in progress
+        m_measureThread->wait();
+        delete m_measureThread;
+    }
+    if (m_quantize) {
+        m_quantize->disconnect(this);
+        m_quantize->kill();
+        m_quantize->waitForFinished();
+        QFile::remove(m_quantizeTarget); // Half-written
+    }
+}
+
+QString SettingsDialog::getSelectedModelPath() const
+{
+    const QString data = comboModel->currentData().toString();
+    if (data == "default") return QCoreApplication::applicationDirPath() + "/models/ggml-base.en.bin";
+    if (data == "custom") return m_customModelPath;
+    // Listed entries are canonical paths; keep the saved spelling so an unchanged model isn't reloaded
+    const QString saved = DatabaseManager::instance().getSetting("model_path");
+    return QFileInfo(saved).canonicalFilePath() == data ? saved : data;
+}
+
+int SettingsDialog::getSelectedShortcutPreset() const
+{
+    return comboShortcut->currentData().toInt();
+}
+
+void SettingsDialog::refreshModels(const QString &selectPath)
+{
+    const QString select = selectPath.isEmpty() ? comboModel->currentData().toString() : selectPath;
+    m_models = ModelCatalog::discover();
+    {
+        QSignalBlocker blocker(comboModel);
+        comboModel->clear();
+        comboModel->addItem("Default (Small English)", "default");
+        for (const ModelCatalog::Entry &entry : m_models) comboModel->addItem(entry.label(), entry.path);
+        comboModel->addItem("Custom Path...", "custom");
+        const int idx = comboModel->findData(select);
+        comboModel->setCurrentIndex(idx >= 0 ? idx : 0);
+    }
+    updateModelControls();
+}
+
+void SettingsDialog::updateModelControls()
+{
+    const QString data = comboModel->currentData().toString();
+    btnBrowse->setEnabled(data == "custom");
+    if (data == "default") lblModelPath->setText("Path: Built-in Default");
+    else if (data == "custom") lblModelPath->setText(m_customModelPath.isEmpty() ? "Path: None selected" : m_customModelPath);
+    else lblModelPath->setText(data);
+
+    // Quantizing only makes sense from full-precision weights
+    const ModelCatalog::Entry *selected = nullptr;
+    for (const ModelCatalog::Entry &entry : m_models) {
+        if (entry.path == data) selected = &entry;
+    }
+    const bool haveTool = !ModelCatalog::quantizeTool().isEmpty();
+    btnQuantize->setEnabled(haveTool && !m_quantize && selected && !selected->isQuantized());
+    btnQuantize->setToolTip(haveTool ? "Writes a q5_0 copy of the selected f16 model (about a third of the size)"
+                                     : "Needs whisper.cpp's whisper-quantize tool next to Toice or on PATH");
+
+    btnMeasure->setText(m_measureThread ? "Stop Measuring" : "Measure Models");
+    btnMeasure->setEnabled(!m_models.isEmpty());
+
+    const double floor = comboFloor->currentData().toDouble();
+    m_recommended = ModelCatalog::recommend(m_models, floor);
+    if (m_measureThread) {
+        return; // The measuring thread owns the label meanwhile
+    } else if (m_recommended >= 0) {
+        lblRecommendation->setText("Recommended (fastest at " + QString::number(floor) + "% or better): "
+                                   + m_models.at(m_recommended).label());
+    } else if (std::any_of(m_models.begin(), m_models.end(), [](const ModelCatalog::Entry &e) { return e.isMeasured(); })) {
+        lblRecommendation->setText("No measured model reaches " + QString::number(floor) + "% accuracy.");
+    } else {
+        lblRecommendation->setText("Measure the models to get a recommendation (decodes a short reference clip with each).");
+    }
+    btnUseRecommended->setEnabled(m_recommended >= 0 && m_models.at(m_recommended).path != data);
+}
+
+// Each model is loaded and timed on its own thread; a click while running stops it
+void SettingsDialog::startMeasuring()
+{
+    if (m_measureThread) {
+        m_cancelMeasure = true;
+        return;
+    }
+    const ModelCatalog::Reference reference = ModelCatalog::referenceClip();
+    if (!reference.isValid()) {
+        lblRecommendation->setText("The reference clip is not installed (share/toice/reference/jfk.wav).");
+        return;
+    }
+
+    const QVector<ModelCatalog::Entry> models = m_models;
+    const int threads = InferenceWorker::configuredThreads();
+    const DecodingPolicy policy = DecodingPolicy::fromSettings();
+    m_cancelMeasure = false;
+    m_measureThread = QThread::create([this, models, reference, policy, threads]() {
+        CpuTopology::instance().pinCurrentThread(CpuTopology::Performance);
+        for (int i = 0; i < models.size() && !m_cancelMeasure; ++i) {
+            ModelCatalog::Entry entry = models.at(i);
+            QMetaObject::invokeMethod(this, [this, i, count = models.size(), label = entry.label()]() {
+                lblRecommendation->setText(QString("Measuring %1 of %2: %3").arg(i + 1).arg(count).arg(label));
+            });
+            if (!ModelCatalog::measure(entry, reference, policy, threads, &m_cancelMeasure)) continue;
+            QMetaObject::invokeMethod(this, [entry]() { ModelCatalog::saveMeasurement(entry); }); // Database is GUI-thread only
+        }
+    });
+    connect(m_measureThread, &QThread::finished, this, [this]() {
+        m_measureThread->deleteLater();
+        m_measureThread = nullptr;
+        refreshModels(QString()); // Picks up the saved measurements
+    });
+    m_measureThread->start(QThread::LowPriority);
+    updateModelControls();
+}
+
+void SettingsDialog::startQuantizing()
+{
+    const QString source = comboModel->currentData().toString();
+    m_quantizeTarget = ModelCatalog::quantizedPath(source, "q5_0");
+    m_quantize = new QProcess(this);
+    connect(m_quantize, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) return; // Anything else also ends in finished()
+        m_quantize->deleteLater();
+        m_quantize = nullptr;
+        updateModelControls();
+        lblRecommendation->setText("Could not start the quantize tool.");
+    });
+    connect(m_quantize, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus status) {
+        ModelCatalog::Entry entry;
+        const bool ok = status == QProcess::NormalExit && exitCode == 0 && ModelCatalog::readHeader(m_quantizeTarget, entry);
+        if (!ok) {
+            qWarning() << "Quantization failed:" << m_quantize->readAllStandardError().right(500);
+            QFile::remove(m_quantizeTarget);
+        }
+        m_quantize->deleteLater();
+        m_quantize = nullptr;
+        refreshModels(ok ? entry.path : QString());
+        lblRecommendation->setText(ok ? "Quantized to " + entry.path + ". Measure it to compare." : "Quantization failed.");
+    });
+    m_quantize->start(ModelCatalog::quantizeTool(), {source, m_quantizeTarget, "q5_0"});
+    if (!m_quantize) return; // Failed to start
+    updateModelControls();
+    lblRecommendation->setText("Quantizing to q5_0...");
 }
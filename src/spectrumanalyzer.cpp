@@ -0,0 +1,127 @@
+#include "spectrumanalyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+// Display range of the band meters, dB relative to a full-scale sine
+static const float kFloorDb = -80.0f;
+static const float kCeilingDb = -10.0f;
+
+static void multiplyInto(float *dest, const float *a, const float *b, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+#endif
+#if defined(__SSE__)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#endif
+    for (; i < n; ++i) dest[i] = a[i] * b[i];
+}
+
+static void powerInto(float *dest, const float *re, const float *im, float scale, int n)
+{
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 s8 = _mm256_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i);
+        __m256 m = _mm256_loadu_ps(im + i);
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(m, m)), s8));
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 s4 = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)), s4));
+    }
+#endif
+    for (; i < n; ++i) dest[i] = (re[i] * re[i] + im[i] * im[i]) * scale;
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(int fftSize, int sampleRate, int bandCount, float minHz, float maxHz)
+    : m_fft(fftSize), m_sampleRate(sampleRate), m_hop(fftSize / 2)
+{
+    m_window.resize(fftSize);
+    for (int i = 0; i < fftSize; ++i) {
+        m_window[i] = 0.5f - 0.5f * std::cos(2.0f * float(M_PI) * i / fftSize);
+    }
+    m_history.assign(fftSize, 0.0f);
+    m_re.resize(fftSize);
+    m_im.resize(fftSize);
+    m_power.assign(fftSize / 2 + 1, 0.0f);
+    m_bands.assign(bandCount, 0.0f);
+
+    // Log-spaced band edges, at least one bin per band
+    const float binHz = float(sampleRate) / fftSize;
+    const int lastBin = fftSize / 2;
+    m_bandEdges.resize(bandCount + 1);
+    for (int b = 0; b <= bandCount; ++b) {
+        const float hz = minHz * std::pow(maxHz / minHz, float(b) / bandCount);
+        int bin = int(std::lround(hz / binHz));
+        if (b > 0) bin = std::max(bin, m_bandEdges[b - 1] + 1);
+        m_bandEdges[b] = std::min(bin, lastBin);
+    }
+}
+
+void SpectrumAnalyzer::reset()
+{
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    std::fill(m_power.begin(), m_power.end(), 0.0f);
+    std::fill(m_bands.begin(), m_bands.end(), 0.0f);
+    m_pending = 0;
+}
+
+bool SpectrumAnalyzer::process(const float *samples, int count)
+{
+    const int size = int(m_history.size());
+    bool produced = false;
+
+    while (count > 0) {
+        const int take = std::min(count, m_hop - m_pending);
+        std::memmove(m_history.data(), m_history.data() + take, (size - take) * sizeof(float));
+        std::memcpy(m_history.data() + size - take, samples, take * sizeof(float));
+        samples += take;
+        count -= take;
+        m_pending += take;
+
+        if (m_pending == m_hop) {
+            analyzeFrame();
+            m_pending = 0;
+            produced = true;
+        }
+    }
+    return produced;
+}
+
+void SpectrumAnalyzer::analyzeFrame()
+{
+    const int size = m_fft.size();
+    multiplyInto(m_re.data(), m_history.data(), m_window.data(), size);
+    std::fill(m_im.begin(), m_im.end(), 0.0f);
+    m_fft.forward(m_re.data(), m_im.data());
+
+    // A Hann-windowed sine of amplitude A peaks at A * N / 4, so this scale
+    // makes a full-scale sine read 1.0 (0 dB)
+    const float norm = 4.0f / size;
+    powerInto(m_power.data(), m_re.data(), m_im.data(), norm * norm, int(m_power.size()));
+
+    for (size_t b = 0; b < m_bands.size(); ++b) {
+        const int from = m_bandEdges[b];
+        const int to = std::max(m_bandEdges[b + 1], from + 1);
+        float sum = 0.0f;
+        for (int k = from; k < to && k < int(m_power.size()); ++k) sum += m_power[k];
+        const float db = 10.0f * std::log10(sum / (to - from) + 1e-12f);
+        m_bands[b] = std::clamp((db - kFloorDb) / (kCeilingDb - kFloorDb), 0.0f, 1.0f);
+    }
+}
@@ -0,0 +1,100 @@
+#include "threadcalibrator.h"
+#include "cputopology.h"
+#include "decodingpolicy.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <cmath>
+
+static const int kClipMs = 5000;
+static const int kSampleRate = 16000;
+
+QString ThreadCalibrator::cpuModel()
+{
+    QString model = "unknown";
+    QFile cpuinfo("/proc/cpuinfo");
+    if (cpuinfo.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : cpuinfo.readAll().split('\n')) {
+            if (line.startsWith("model name")) {
+                model = QString::fromUtf8(line.mid(line.indexOf(':') + 1)).trimmed();
+                break;
+            }
+        }
+    }
+    return QString("%1 x%2").arg(model).arg(QThread::idealThreadCount());
+}
+
+// A spread of counts up to the logical CPU count, always including it
+QVector<int> ThreadCalibrator::candidates(int cpus)
+{
+    QVector<int> counts;
+    for (int n : {1, 2, 3, 4, 6, 8, 12, 16, 24, 32}) {
+        if (n < cpus && (n > 1 || cpus <= 2)) counts.append(n);
+    }
+    counts.append(qMax(1, cpus));
+    return counts;
+}
+
+// Voiced-speech-like test signal: a harmonic stack with a drifting pitch,
+// amplitude-modulated at a syllable rate, so the decoder produces tokens
+static QVector<float> makeClip()
+{
+    QVector<float> clip(kSampleRate * kClipMs / 1000);
+    double phase = 0.0;
+    for (int i = 0; i < clip.size(); ++i) {
+        const double t = double(i) / kSampleRate;
+        const double pitch = 140.0 + 30.0 * std::sin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * pitch / kSampleRate;
+        double v = 0.0;
+        for (int h = 1; h <= 8; ++h) v += std::sin(h * phase) / h;
+        const double envelope = 0.5 + 0.5 * std::sin(2.0 * M_PI * 4.0 * t);
+        clip[i] = float(0.1 * envelope * v);
+    }
+    return clip;
+}
+
+ThreadCalibrator::Result ThreadCalibrator::run(WhisperStatePool &model, const std::atomic<bool> *cancel)
+{
+    Result result;
+    WhisperStatePool::Lease lease = model.acquire();
+    if (!lease) return result;
+
+    const QVector<float> clip = makeClip();
+    // Greedy with no fallback: whisper's own would re-decode a low-confidence
+    // window (likely on a synthetic clip) at some counts and not others
+    DecodingPolicy fixed;
+    fixed.maxFallbacks = 0;
+    whisper_full_params wparams = fixed.params(1);
+    wparams.abort_callback = [](void *userData) {
+        return static_cast<const std::atomic<bool>*>(userData)->load(std::memory_order_relaxed);
+    };
+    wparams.abort_callback_user_data = const_cast<std::atomic<bool>*>(cancel);
+
+    // Warm-up pass so the first candidate doesn't pay for cold caches
+    wparams.n_threads = qMin(4, CpuTopology::instance().computeCpuCount());
+    if (whisper_full_with_state(model.context(), lease.state(), wparams, clip.constData(), int(clip.size())) != 0) return result;
+
+    qint64 best = -1;
+    for (int threads : candidates(CpuTopology::instance().computeCpuCount())) {
+        wparams.n_threads = threads;
+        // Best of two, so one preempted run doesn't decide the count
+        qint64 ms = -1;
+        for (int run = 0; run < 2; ++run) {
+            QElapsedTimer timer;
+            timer.start();
+            if (whisper_full_with_state(model.context(), lease.state(), wparams, clip.constData(), int(clip.size())) != 0) {
+                result.threads = 0; // Cancelled: a partial sweep isn't worth keeping
+                return result;
+            }
+            ms = ms < 0 ? timer.elapsed() : qMin(ms, timer.elapsed());
+        }
+        result.timings.append({threads, ms});
+        // Fewer threads win ties within 5%: same speed, less contention
+        if (best < 0 || ms < best * 0.95) {
+            best = ms;
+            result.threads = threads;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,46 @@
+#include "transcriptstitcher.h"
+
+void TranscriptStitcher::clear()
+{
+    m_words.clear();
+}
+
+// Case and punctuation differ between two decodes of the same words
+QString TranscriptStitcher::normalized(const QString &word)
+{
+    QString out;
+    out.reserve(word.size());
+    for (const QChar c : word) {
+        if (c.isLetterOrNumber()) out += c.toLower();
+    }
+    return out;
+}
+
+void TranscriptStitcher::append(const QString &chunkText, bool overlapped)
+{
+    const QStringList words = chunkText.split(' ', Qt::SkipEmptyParts);
+    if (words.isEmpty()) return;
+
+    // Longest run of words ending the text so far that also starts the chunk
+    const int minOverlap = overlapped ? 1 : 2;
+    int overlap = 0;
+    for (int n = qMin<int>(kMaxOverlapWords, qMin(m_words.size(), words.size())); n >= minOverlap; --n) {
+        bool match = true;
+        for (int i = 0; i < n && match; ++i) {
+            const QString a = normalized(m_words[m_words.size() - n + i]);
+            match = !a.isEmpty() && a == normalized(words[i]);
+        }
+        if (match) {
+            overlap = n;
+            break;
+        }
+    }
+
+    for (int i = overlap; i < words.size(); ++i) m_words.append(words[i]);
+}
+
+QString TranscriptStitcher::tail(int maxChars) const
+{
+    const QString all = text();
+    return all.size() <= maxChars ? all : all.right(maxChars);
+}
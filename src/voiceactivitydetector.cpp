@@ -0,0 +1,163 @@
+#include "voiceactivitydetector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Decision thresholds, tuned on office/laptop microphones
+static const float kMinSpeechDb = -55.0f;      // Absolute floor (dBFS) for anything we call speech
+static const float kAboveNoiseDb = 9.0f;       // Required margin over the tracked noise floor
+static const float kMinSpeechBandRatio = 0.5f; // Share of energy in 250-3500 Hz
+static const float kMaxFlatness = 0.5f;        // White noise is ~1, voiced speech well below
+static const float kFloorRiseDb = 0.1f;        // Per frame (~3 dB/s) so the floor follows rising noise
+static const int kOnsetFrames = 2;             // ~64 ms of speech-like frames to open a segment
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate)
+    : m_fft(kFrameSize), m_sampleRate(sampleRate)
+{
+    m_frame.assign(kFrameSize, 0.0f);
+    m_re.assign(kFrameSize, 0.0f);
+    m_im.assign(kFrameSize, 0.0f);
+
+    const float binHz = float(sampleRate) / kFrameSize;
+    m_speechBinFrom = std::max(1, int(250.0f / binHz));
+    m_speechBinTo = std::min(kFrameSize / 2, int(3500.0f / binHz));
+
+    setHangoverMs(300);
+    reset();
+}
+
+void VoiceActivityDetector::reset()
+{
+    m_frameFill = 0;
+    m_position = 0;
+    m_frameStart = 0;
+    m_floorInitialised = false;
+    m_onsetRun = 0;
+    m_silenceRun = 0;
+    m_lastSpeechEnd = 0;
+    m_inSpeech = false;
+    m_open = Segment();
+    m_segments.clear();
+}
+
+void VoiceActivityDetector::setHangoverMs(int ms)
+{
+    const int frameMs = 1000 * kFrameSize / m_sampleRate;
+    m_hangoverFrames = std::max(0, (ms + frameMs - 1) / frameMs);
+}
+
+void VoiceActivityDetector::process(const float *samples, int count)
+{
+    while (count > 0) {
+        const int take = std::min(count, kFrameSize - m_frameFill);
+        std::memcpy(m_frame.data() + m_frameFill, samples, take * sizeof(float));
+        m_frameFill += take;
+        m_position += take;
+        samples += take;
+        count -= take;
+
+        if (m_frameFill == kFrameSize) {
+            classifyFrame();
+            m_frameStart += kFrameSize;
+            m_frameFill = 0;
+        }
+    }
+}
+
+void VoiceActivityDetector::classifyFrame()
+{
+    // Energy
+    float sumSquares = 0.0f;
+    for (int i = 0; i < kFrameSize; ++i) sumSquares += m_frame[i] * m_frame[i];
+    const float energyDb = 10.0f * std::log10(sumSquares / kFrameSize + 1e-10f);
+
+    // Spectral cues (Hann window, magnitude squared)
+    for (int i = 0; i < kFrameSize; ++i) {
+        const float w = 0.5f - 0.5f * std::cos(2.0f * float(M_PI) * i / kFrameSize);
+        m_re[i] = m_frame[i] * w;
+        m_im[i] = 0.0f;
+    }
+    m_fft.forward(m_re.data(), m_im.data());
+
+    float total = 1e-12f, speech = 1e-12f, logSum = 0.0f;
+    for (int k = 2; k <= kFrameSize / 2; ++k) {
+        const float p = m_re[k] * m_re[k] + m_im[k] * m_im[k];
+        total += p;
+        if (k >= m_speechBinFrom && k <= m_speechBinTo) {
+            speech += p;
+            logSum += std::log(p + 1e-12f);
+        }
+    }
+    const int speechBins = m_speechBinTo - m_speechBinFrom + 1;
+    const float bandRatio = speech / total;
+    const float flatness = std::exp(logSum / speechBins) / (speech / speechBins);
+
+    if (!m_floorInitialised) {
+        m_noiseFloorDb = energyDb;
+        m_floorInitialised = true;
+    }
+
+    const bool speechLike = energyDb > kMinSpeechDb
+                         && energyDb > m_noiseFloorDb + kAboveNoiseDb
+                         && bandRatio > kMinSpeechBandRatio
+                         && flatness < kMaxFlatness;
+
+    // Noise floor: follows drops quickly, rises slowly, frozen during speech
+    if (energyDb < m_noiseFloorDb) {
+        m_noiseFloorDb = 0.7f * m_noiseFloorDb + 0.3f * energyDb;
+    } else if (!speechLike && !m_inSpeech) {
+        m_noiseFloorDb += std::min(kFloorRiseDb, energyDb - m_noiseFloorDb);
+    }
+
+    const int64_t frameEnd = m_frameStart + kFrameSize;
+    const int64_t hangoverSamples = int64_t(m_hangoverFrames) * kFrameSize;
+
+    if (!m_inSpeech) {
+        if (speechLike) {
+            if (m_onsetRun == 0) m_onsetStart = m_frameStart;
+            if (++m_onsetRun >= kOnsetFrames) {
+                m_inSpeech = true;
+                m_open.start = m_onsetStart;
+                m_lastSpeechEnd = frameEnd;
+                m_silenceRun = 0;
+            }
+        } else {
+            m_onsetRun = 0;
+        }
+        return;
+    }
+
+    if (speechLike) {
+        m_lastSpeechEnd = frameEnd;
+        m_silenceRun = 0;
+    } else if (++m_silenceRun > m_hangoverFrames) {
+        m_open.end = std::min(m_lastSpeechEnd + hangoverSamples, frameEnd);
+        m_segments.push_back(m_open);
+        m_inSpeech = false;
+        m_onsetRun = 0;
+    }
+}
+
+void VoiceActivityDetector::finish()
+{
+    if (!m_inSpeech) return;
+    m_open.end = std::min(m_lastSpeechEnd + int64_t(m_hangoverFrames) * kFrameSize, m_position);
+    m_segments.push_back(m_open);
+    m_inSpeech = false;
+    m_onsetRun = 0;
+}
+
+VoiceActivityDetector::Segment VoiceActivityDetector::speechBounds(int paddingMs) const
+{
+    Segment bounds;
+    if (!hasSpeech()) return bounds;
+
+    const int64_t padding = int64_t(paddingMs) * m_sampleRate / 1000;
+    const int64_t first = m_segments.empty() ? m_open.start : m_segments.front().start;
+    const int64_t last = m_inSpeech ? m_lastSpeechEnd : m_segments.back().end;
+
+    bounds.start = std::max<int64_t>(0, first - padding);
+    bounds.end = std::min<int64_t>(m_position, last + padding);
+    if (bounds.end < bounds.start) bounds.end = bounds.start;
+    return bounds;
+}
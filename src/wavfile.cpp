@@ -0,0 +1,57 @@
+#include "wavfile.h"
+#include "audioconverter.h"
+#include <QByteArray>
+#include <QFile>
+#include <cstring>
+
+bool WavFile::load(const QString &path, QVector<float> &out)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray bytes = file.readAll();
+    if (bytes.size() < 12 || !bytes.startsWith("RIFF") || bytes.mid(8, 4) != "WAVE") return false;
+
+    auto u16 = [&](qsizetype at) { quint16 v; memcpy(&v, bytes.constData() + at, 2); return v; };
+    auto u32 = [&](qsizetype at) { quint32 v; memcpy(&v, bytes.constData() + at, 4); return v; };
+
+    int formatTag = 0, channels = 0, rate = 0, bits = 0;
+    qsizetype dataAt = -1, dataSize = 0;
+    for (qsizetype at = 12; at + 8 <= bytes.size();) {
+        const QByteArray id = bytes.mid(at, 4);
+        const qsizetype size = u32(at + 4);
+        if (id == "fmt " && size >= 16) {
+            formatTag = u16(at + 8);
+            channels = u16(at + 10);
+            rate = int(u32(at + 12));
+            bits = u16(at + 22);
+            if (formatTag == 0xFFFE && size >= 26) formatTag = u16(at + 32); // WAVE_FORMAT_EXTENSIBLE
+        } else if (id == "data") {
+            dataAt = at + 8;
+            dataSize = qMin(size, bytes.size() - dataAt);
+        }
+        at += 8 + size + (size & 1);
+    }
+
+    AudioConverter::SampleFormat format;
+    if (formatTag == 3 && bits == 32) format = AudioConverter::Float;
+    else if (formatTag == 1 && bits == 16) format = AudioConverter::Int16;
+    else if (formatTag == 1 && bits == 32) format = AudioConverter::Int32;
+    else if (formatTag == 1 && bits == 8) format = AudioConverter::UInt8;
+    else return false;
+    if (dataAt < 0 || channels <= 0 || rate <= 0) return false;
+
+    AudioConverter converter;
+    converter.configure(format, rate, channels);
+    const int frameBytes = converter.bytesPerFrame();
+    const qsizetype frames = dataSize / frameBytes;
+    QVector<float> chunk(converter.maxOutputSamples());
+    out.clear();
+    for (qsizetype frame = 0; frame < frames; frame += AudioConverter::kChunkFrames) {
+        const int count = int(qMin<qsizetype>(AudioConverter::kChunkFrames, frames - frame));
+        const int produced = converter.process(bytes.constData() + dataAt + frame * frameBytes, count, chunk.data());
+        const qsizetype at = out.size();
+        out.resize(at + produced);
+        memcpy(out.data() + at, chunk.constData(), size_t(produced) * sizeof(float));
+    }
+    return true;
+}
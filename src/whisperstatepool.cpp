@@ -0,0 +1,102 @@
+#include "whisperstatepool.h"
+#include "modelfile.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+WhisperStatePool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool), m_state(other.m_state)
+{
+    other.m_pool = nullptr;
+    other.m_state = nullptr;
+}
+
+WhisperStatePool::Lease &WhisperStatePool::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_state = other.m_state;
+        other.m_pool = nullptr;
+        other.m_state = nullptr;
+    }
+    return *this;
+}
+
+WhisperStatePool::Lease::~Lease()
+{
+    release();
+}
+
+void WhisperStatePool::Lease::release()
+{
+    if (m_pool && m_state) m_pool->giveBack(m_state);
+    m_pool = nullptr;
+    m_state = nullptr;
+}
+
+WhisperStatePool::WhisperStatePool(whisper_context *ctx, int maxStates)
+    : m_ctx(ctx), m_maxStates(qMax(1, maxStates))
+{
+    if (!m_ctx) return;
+    QMutexLocker locker(&m_mutex);
+    if (whisper_state *state = takeLocked()) m_free.append(state);
+}
+
+std::shared_ptr<WhisperStatePool> WhisperStatePool::load(ModelFile &file, int maxStates)
+{
+    whisper_model_loader loader = file.loader();
+    whisper_context *context = whisper_init_with_params_no_state(&loader, whisper_context_default_params());
+    if (!context) return nullptr;
+    auto pool = std::make_shared<WhisperStatePool>(context, maxStates);
+    return pool->isValid() ? pool : nullptr;
+}
+
+WhisperStatePool::~WhisperStatePool()
+{
+    // Leases hold a reference to whoever owns the pool, so none are out by now
+    for (whisper_state *state : std::as_const(m_all)) whisper_free_state(state);
+    if (m_ctx) whisper_free(m_ctx);
+}
+
+// A free state if there is one, otherwise a new one while under the cap
+whisper_state *WhisperStatePool::takeLocked()
+{
+    if (!m_free.isEmpty()) return m_free.takeLast();
+    if (m_all.size() >= m_maxStates) return nullptr;
+
+    QElapsedTimer timer;
+    timer.start();
+    whisper_state *state = whisper_init_state(m_ctx);
+    if (!state) {
+        qWarning() << "Could not allocate whisper state" << m_all.size() + 1;
+        return nullptr;
+    }
+    m_all.append(state);
+    qDebug() << "Allocated whisper state" << m_all.size() << "of" << m_maxStates << "in" << timer.elapsed() << "ms";
+    return state;
+}
+
+WhisperStatePool::Lease WhisperStatePool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    whisper_state *state;
+    while (!(state = takeLocked())) {
+        if (m_all.isEmpty()) return Lease(); // Can't allocate even one: don't wait forever
+        m_returned.wait(&m_mutex);
+    }
+    return Lease(this, state);
+}
+
+WhisperStatePool::Lease WhisperStatePool::tryAcquire()
+{
+    QMutexLocker locker(&m_mutex);
+    whisper_state *state = takeLocked();
+    return state ? Lease(this, state) : Lease();
+}
+
+void WhisperStatePool::giveBack(whisper_state *state)
+{
+    QMutexLocker locker(&m_mutex);
+    m_free.append(state);
+    m_returned.wakeOne();
+}